@@ -4,8 +4,11 @@
  * + reading a memory buffer from left to right
  * + reading from a FILE * (not seekable too)
  * + reading from a file descriptor (on Linux)
+ * + decompressing gzip, zlib or raw DEFLATE data of another source (with zlib)
  *
  * Other ways like reading from a HANDLE on Windows may be added easily.
+ *
+ * C++ programs may use the wrapper in libis.hpp instead.
  */
 
 #ifndef LIBIS_H
@@ -15,11 +18,21 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define LIBIS_LOOKAHEAD_MIN 2
 
 // Structure that must be passed to all library functions.
 typedef struct Libis_ Libis;
 
+// Compiled description of a binary record. See libis_schema_compile().
+typedef struct LibisSchema_ LibisSchema;
+
+// State of RLE/bit-packing hybrid decoding. See libis_rle_decoder_create().
+typedef struct LibisRleDecoder_ LibisRleDecoder;
+
 // Interface of input source: FILE, buffer, file descriptor, HANDLE...
 // Something that we can read from byte by byte.
 typedef struct LibisSource_ LibisSource;
@@ -34,8 +47,18 @@ typedef enum {
     LIBIS_ERROR_IO, // underlying system IO error
     LIBIS_ERROR_TOO_FAR, // attempt to look ahead too far
     LIBIS_ERROR_HANGING_BITS, // a group of calls to libis_read_bits() didn't end up reading whole number of bytes
+    LIBIS_ERROR_NOT_SUPPORTED, // the source doesn't support requested operation
+    LIBIS_ERROR_MALFORMED, // input doesn't follow the format it is read as
+    LIBIS_ERROR_OUT_OF_RANGE, // value read doesn't fit into its type
 } LibisError;
 
+// Checksums which can be computed over bytes consumed from LibisInputStream.
+typedef enum {
+    LIBIS_CRC32, // CRC-32 of zlib, gzip, PNG, Ethernet
+    LIBIS_CRC32C, // CRC-32C (Castagnoli) of iSCSI, ext4, SCTP
+    LIBIS_XXH64, // XXH64 with zero seed
+} LibisChecksumKind;
+
 // Initialize *libis.
 LibisError libis_start(Libis **libis);
 
@@ -51,13 +74,75 @@ LibisError libis_source_create_from_buffer(
         Libis *libis, LibisSource **source, const char *buffer, size_t size, bool own);
 
 #if defined(__linux__)
+// Options for reading a file descriptor. Useful for long sequential scans of huge files.
+typedef enum {
+    LIBIS_FD_SEQUENTIAL = 1 << 0, // advise the kernel that the file gets read sequentially
+    LIBIS_FD_DROP_BEHIND = 1 << 1, // drop bytes from page cache once they are read
+    LIBIS_FD_DIRECT = 1 << 2, // bypass page cache with O_DIRECT if the file system supports it
+} LibisFileDescriptorFlags;
+
 // Create LibisSource from a file descriptor.
 LibisError libis_source_create_from_file_descriptor(Libis *libis, LibisSource **source, int *file_descriptor);
+
+// Create LibisSource from a file descriptor with LibisFileDescriptorFlags combined in flags.
+// Flags are ignored for file descriptors which are not seekable.
+LibisError libis_source_create_from_file_descriptor_with_flags(
+        Libis *libis, LibisSource **source, int *file_descriptor, unsigned flags);
+
+// Get LibisFileDescriptorFlags which are in effect for source created from a file descriptor.
+// LIBIS_FD_DIRECT gets dropped when the file system refuses O_DIRECT or reading starts at an
+// offset which is not aligned for it. Returns LIBIS_ERROR_NOT_SUPPORTED for other sources.
+LibisError libis_source_get_file_descriptor_flags(Libis *libis, LibisSource *source, unsigned *flags);
+
+#endif
+
+#if defined(LIBIS_WITH_ZLIB)
+// Formats of DEFLATE compressed data
+typedef enum {
+    LIBIS_FORMAT_GZIP, // gzip file, concatenated members are read as one stream
+    LIBIS_FORMAT_ZLIB, // zlib stream
+    LIBIS_FORMAT_RAW, // raw DEFLATE without header and trailer
+} LibisCompressionFormat;
+
+// Create LibisSource which decompresses bytes of inner source. Takes ownership of *inner
+// unless libis is NULL.
+// Reading corrupted or truncated data fails with LIBIS_ERROR_MALFORMED.
+LibisError libis_source_create_inflate(
+        Libis *libis, LibisSource **source, LibisSource **inner, LibisCompressionFormat format);
+
 #endif
 
 // Free resources taken by LibisSource.
 LibisError libis_source_destroy(Libis *libis, LibisSource **source);
 
+// Read size bytes at offset from source into dst. Doesn't change state of the source so
+// many threads may read from the same source at once without locking. A source passed
+// to libis_create() must not be used with these functions.
+// *eof sets to whether end of file is reached before size bytes are read.
+// Buffer and file descriptor sources support positional reads, FILE source doesn't.
+LibisError libis_read_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, char *dst, size_t size);
+
+// Read byte at offset from source. See libis_read_at().
+LibisError libis_read_u8_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint8_t *out);
+
+// Read 2 bytes in little endian at offset from source. See libis_read_at().
+LibisError libis_read_u16_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint16_t *out);
+
+// Read 2 bytes in big endian at offset from source. See libis_read_at().
+LibisError libis_read_u16_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint16_t *out);
+
+// Read 4 bytes in little endian at offset from source. See libis_read_at().
+LibisError libis_read_u32_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint32_t *out);
+
+// Read 4 bytes in big endian at offset from source. See libis_read_at().
+LibisError libis_read_u32_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint32_t *out);
+
+// Read 8 bytes in little endian at offset from source. See libis_read_at().
+LibisError libis_read_u64_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint64_t *out);
+
+// Read 8 bytes in big endian at offset from source. See libis_read_at().
+LibisError libis_read_u64_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint64_t *out);
+
 // Create LibisInputStream from LibisSource capable to look ahead by lookahead bytes.
 LibisError libis_create(Libis *libis, LibisInputStream **input, LibisSource **source, size_t lookahead);
 
@@ -68,6 +153,17 @@ LibisError libis_destroy(Libis *libis, LibisInputStream **input);
 // *eof sets to whether end of file is reached. If so *out sets to '\0'.
 LibisError libis_lookahead(Libis *libis, LibisInputStream *input, bool *eof, size_t offset, char *out);
 
+// Get unread bytes of the buffer without consuming them making at least size of them available
+// unless input ends earlier. size is limited by buffer capacity rather than lookahead.
+// *window sets to the first unread byte and *available to the number of unread bytes.
+// The window stays valid until the next call which reads from input.
+// *eof sets to whether end of file is reached before size bytes are available.
+LibisError libis_peek(
+        Libis *libis, LibisInputStream *input, bool *eof, size_t size, const char **window, size_t *available);
+
+// Consume size bytes of the window returned by libis_peek().
+LibisError libis_consume(Libis *libis, LibisInputStream *input, size_t size);
+
 // Read next character from LibisInputStream.
 // *eof sets to whether end of file is reached. If so *out sets to '\0'.
 LibisError libis_read_char(Libis *libis, LibisInputStream *input, bool *eof, char *out);
@@ -109,4 +205,117 @@ LibisError libis_read_u64_le(Libis *libis, LibisInputStream *input, bool *eof, u
 // *eof sets to whether end of file is reached. If so *out sets to '\0'.
 LibisError libis_read_u64_be(Libis *libis, LibisInputStream *input, bool *eof, uint64_t *out);
 
+// Read count unsigned integers of bit_width bits (from 1 to 32) packed one right after another.
+// Values are packed starting from the least significant bit of each byte like in Parquet and ORC.
+// ceil(count * bit_width / 8) bytes get read. Trailing bits of the last byte are ignored.
+// *eof sets to whether end of file is reached before all values are read.
+LibisError libis_read_bitpacked_u32(
+        Libis *libis, LibisInputStream *input, bool *eof, unsigned bit_width, uint32_t *out, size_t count);
+
+// Same as libis_read_bitpacked_u32() for bit_width from 1 to 64.
+LibisError libis_read_bitpacked_u64(
+        Libis *libis, LibisInputStream *input, bool *eof, unsigned bit_width, uint64_t *out, size_t count);
+
+// Create decoder of unsigned integers of bit_width bits (from 0 to 32) encoded with the
+// RLE/bit-packing hybrid encoding of Parquet.
+LibisError libis_rle_decoder_create(Libis *libis, LibisRleDecoder **decoder, unsigned bit_width);
+
+// Free resources taken by LibisRleDecoder.
+LibisError libis_rle_decoder_destroy(Libis *libis, LibisRleDecoder **decoder);
+
+// Forget the rest of the current run, e.g. to start decoding the next page.
+LibisError libis_rle_decoder_reset(Libis *libis, LibisRleDecoder *decoder);
+
+// Read at most count values with decoder. Runs may span calls so a page can be decoded in batches.
+// *nread sets to the number of values read.
+// *eof sets to whether end of file is reached before all values are read.
+LibisError libis_read_rle_bitpacked_hybrid_u32(Libis *libis, LibisInputStream *input, bool *eof,
+        LibisRleDecoder *decoder, uint32_t *out, size_t count, size_t *nread);
+
+// Compile description of a binary record into *schema.
+// Description is a list of fields separated by spaces: u8 u16 u32 u64 i8 i16 i32 i64 f32 f64 bytes[N].
+// '<' and '>' switch byte order of the following fields to little and big endian. Little is the default.
+// Records get stored in memory with the layout of a C struct with the same fields: each field is
+// aligned to its size (bytes[N] to 1) and the size of record is a multiple of the largest alignment.
+// Records may take at most 65536 bytes in input stream.
+// Returns LIBIS_ERROR_BAD_ARGUMENT if description is malformed or the record is too long.
+LibisError libis_schema_compile(Libis *libis, LibisSchema **schema, const char *description);
+
+// Free resources taken by LibisSchema.
+LibisError libis_schema_destroy(Libis *libis, LibisSchema **schema);
+
+// Get size of record in input stream and in memory. Either pointer may be NULL.
+LibisError libis_schema_get_size(Libis *libis, const LibisSchema *schema, size_t *input_size, size_t *record_size);
+
+// Read record described by schema into dst.
+// *eof sets to whether end of file is reached before whole record is read.
+LibisError libis_read_record(
+        Libis *libis, LibisInputStream *input, bool *eof, const LibisSchema *schema, void *dst);
+
+// Read count records described by schema into dst placing them stride bytes apart.
+// *nread sets to the number of whole records read. A truncated record at the end is left unread.
+// *eof sets to whether end of file is reached before all records are read.
+LibisError libis_read_records(Libis *libis, LibisInputStream *input, bool *eof,
+        const LibisSchema *schema, void *dst, size_t count, size_t stride, size_t *nread);
+
+// Read decimal integer [+-]?[0-9]+ written in ASCII. Bytes after the number are left unread.
+// Returns LIBIS_ERROR_MALFORMED if input doesn't start with a number and LIBIS_ERROR_OUT_OF_RANGE
+// if the number doesn't fit into *out. Nothing gets consumed in both cases.
+// *eof sets to whether end of file is reached. If so *out sets to 0.
+LibisError libis_read_int64(Libis *libis, LibisInputStream *input, bool *eof, int64_t *out);
+
+// Same as libis_read_int64() for unsigned integers.
+LibisError libis_read_uint64(Libis *libis, LibisInputStream *input, bool *eof, uint64_t *out);
+
+// Same as libis_read_int64() for hexadecimal integers [+-]?[0-9A-Fa-f]+ without 0x prefix.
+LibisError libis_read_int64_hex(Libis *libis, LibisInputStream *input, bool *eof, int64_t *out);
+
+// Same as libis_read_int64_hex() for unsigned integers.
+LibisError libis_read_uint64_hex(Libis *libis, LibisInputStream *input, bool *eof, uint64_t *out);
+
+// Read floating point number [+-]?([0-9]+[.]?[0-9]*|[.][0-9]+)([eE][+-]?[0-9]+)? written in ASCII.
+// Numbers beyond range of double become infinity or zero. Errors are the same as in libis_read_int64().
+// The radix character is always '.' whatever LC_NUMERIC is.
+LibisError libis_read_double(Libis *libis, LibisInputStream *input, bool *eof, double *out);
+
+// Read next Unicode code point encoded in UTF-8.
+// Returns LIBIS_ERROR_MALFORMED without consuming anything if the next bytes are not valid UTF-8:
+// stray continuation bytes, overlong forms, surrogates, code points beyond U+10FFFF, truncated sequences.
+// *eof sets to whether end of file is reached. If so *out sets to 0.
+LibisError libis_read_codepoint(Libis *libis, LibisInputStream *input, bool *eof, uint32_t *out);
+
+// Read at most size bytes of valid UTF-8 into dst never splitting a code point.
+// *nread sets to the number of bytes read. Reading stops before the first malformed sequence.
+// Once something is read it also stops rather than wait for more input.
+// Returns LIBIS_ERROR_MALFORMED if the stream is positioned at a malformed sequence.
+// *eof sets to whether end of file is reached before anything is read.
+LibisError libis_read_utf8_span(
+        Libis *libis, LibisInputStream *input, bool *eof, char *dst, size_t size, size_t *nread);
+
+// Consume next size bytes and check that they are valid UTF-8. Code points must not cross the end.
+// *eof sets to whether end of file is reached before size bytes are consumed.
+LibisError libis_validate_utf8(Libis *libis, LibisInputStream *input, bool *eof, size_t size, bool *valid);
+
+// Start computing checksum over bytes consumed from input from now on.
+// Checksum in progress if any gets discarded. Bytes are hashed in bulk as they leave the buffer.
+LibisError libis_checksum_begin(Libis *libis, LibisInputStream *input, LibisChecksumKind kind);
+
+// Stop computing checksum and get its value. CRCs are stored in lower 32 bits of *out.
+// Returns LIBIS_ERROR_BAD_ARGUMENT if there is no checksum in progress.
+LibisError libis_checksum_end(Libis *libis, LibisInputStream *input, uint64_t *out);
+
+// Start counting lines and columns of input. The current position becomes line 1, column 1.
+// Lines are counted lazily in bulk as bytes leave the buffer so per byte readers don't pay for it.
+LibisError libis_enable_position_tracking(Libis *libis, LibisInputStream *input);
+
+// Get position of the next byte to read. *offset sets to the number of bytes consumed since creation.
+// *line and *column count from 1, columns are counted in bytes. They are 0 unless tracking is enabled.
+// Any pointer may be NULL.
+LibisError libis_get_position(
+        Libis *libis, LibisInputStream *input, uint64_t *offset, uint64_t *line, uint64_t *column);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,404 @@
+/* C++ interface of libis (requires C++20).
+ *
+ * Provides RAII handles for Libis, LibisSource and LibisInputStream and typed readers
+ * which are templates specialized at compile time for type and byte order. Stream
+ * caches the window of unread bytes obtained with libis_peek() and decodes values
+ * straight from it, so reads inline into the caller and call into the C library only
+ * when the window runs out. Errors are reported with exceptions.
+ */
+
+#ifndef LIBIS_HPP
+#define LIBIS_HPP
+
+#include <libis.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace libis {
+
+// Thrown when a libis function fails.
+class Error : public std::runtime_error {
+public:
+    explicit Error(LibisError code) : std::runtime_error(describe(code)), code_(code) {}
+
+    LibisError code() const noexcept { return code_; }
+
+private:
+    static const char *describe(LibisError code) noexcept {
+        switch (code) {
+        case LIBIS_ERROR_OK: return "libis: ok";
+        case LIBIS_ERROR_OUT_OF_MEMORY: return "libis: out of memory";
+        case LIBIS_ERROR_BAD_ARGUMENT: return "libis: bad argument";
+        case LIBIS_ERROR_IO: return "libis: input/output error";
+        case LIBIS_ERROR_TOO_FAR: return "libis: attempt to look ahead too far";
+        case LIBIS_ERROR_HANGING_BITS: return "libis: bits read don't make whole bytes";
+        case LIBIS_ERROR_NOT_SUPPORTED: return "libis: operation is not supported by the source";
+        case LIBIS_ERROR_MALFORMED: return "libis: malformed input";
+        case LIBIS_ERROR_OUT_OF_RANGE: return "libis: value is out of range";
+        }
+        return "libis: unknown error";
+    }
+
+    LibisError code_;
+};
+
+// Thrown when input ends before a value is read.
+class EndOfStream : public std::runtime_error {
+public:
+    EndOfStream() : std::runtime_error("libis: end of stream") {}
+};
+
+inline void check(LibisError err) {
+    if (err != LIBIS_ERROR_OK) {
+        throw Error(err);
+    }
+}
+
+// Unsigned integer of given size
+template<std::size_t Size> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<1> { using Type = std::uint8_t; };
+template<> struct UnsignedOfSize<2> { using Type = std::uint16_t; };
+template<> struct UnsignedOfSize<4> { using Type = std::uint32_t; };
+template<> struct UnsignedOfSize<8> { using Type = std::uint64_t; };
+
+// Types which typed readers decode: integers and floating point numbers of 1, 2, 4 or 8 bytes.
+template<class T>
+concept Readable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>
+        && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// Reverse bytes of an unsigned integer.
+template<class T>
+constexpr T byteswap(T value) noexcept {
+#if defined(__cpp_lib_byteswap)
+    return std::byteswap(value);
+#else
+    T result = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        result = static_cast<T>(result << 8 | (value & 0xFF));
+        value = static_cast<T>(value >> 8);
+    }
+    return result;
+#endif
+}
+
+// Decode T stored in byte order E at p. Byte order gets resolved at compile time.
+template<Readable T, std::endian E>
+inline T load(const std::byte *p) noexcept {
+    using Bits = typename UnsignedOfSize<sizeof(T)>::Type;
+    Bits bits;
+    std::memcpy(&bits, p, sizeof(T));
+    if constexpr (sizeof(T) > 1 && E != std::endian::native) {
+        bits = byteswap(bits);
+    }
+    return std::bit_cast<T>(bits);
+}
+
+// Owner of Libis
+class Context {
+public:
+    Context() { check(libis_start(&libis_)); }
+
+    ~Context() { libis_finish(&libis_); }
+
+    Context(const Context &) = delete;
+    Context &operator=(const Context &) = delete;
+
+    Context(Context &&other) noexcept : libis_(std::exchange(other.libis_, nullptr)) {}
+
+    Context &operator=(Context &&other) noexcept {
+        if (this != &other) {
+            libis_finish(&libis_);
+            libis_ = std::exchange(other.libis_, nullptr);
+        }
+        return *this;
+    }
+
+    Libis *get() const noexcept { return libis_; }
+
+private:
+    Libis *libis_ = nullptr;
+};
+
+// Owner of LibisSource. Context must outlive it.
+class Source {
+public:
+    // Source reading memory which must outlive the source.
+    static Source from_buffer(Context &context, std::span<const std::byte> buffer) {
+        LibisSource *source = nullptr;
+        const char *data = buffer.data() ? reinterpret_cast<const char *>(buffer.data()) : "";
+        check(libis_source_create_from_buffer(context.get(), &source, data, buffer.size(), false));
+        return Source(context.get(), source);
+    }
+
+    // Source reading file. Takes ownership of file even if it throws.
+    static Source from_file(Context &context, std::FILE *file) {
+        LibisSource *source = nullptr;
+        check(libis_source_create_from_file(context.get(), &source, &file));
+        return Source(context.get(), source);
+    }
+
+#if defined(__linux__)
+    // Source reading file descriptor with LibisFileDescriptorFlags. Takes ownership of file descriptor.
+    static Source from_file_descriptor(Context &context, int file_descriptor, unsigned flags = 0) {
+        LibisSource *source = nullptr;
+        check(libis_source_create_from_file_descriptor_with_flags(context.get(), &source, &file_descriptor, flags));
+        return Source(context.get(), source);
+    }
+#endif
+
+#if defined(LIBIS_WITH_ZLIB)
+    // Source decompressing bytes of inner source.
+    static Source inflate(Context &context, Source &&inner, LibisCompressionFormat format) {
+        LibisSource *source = nullptr;
+        LibisSource *inner_source = inner.release();
+        check(libis_source_create_inflate(context.get(), &source, &inner_source, format));
+        return Source(context.get(), source);
+    }
+#endif
+
+    ~Source() { libis_source_destroy(libis_, &source_); }
+
+    Source(const Source &) = delete;
+    Source &operator=(const Source &) = delete;
+
+    Source(Source &&other) noexcept
+            : libis_(other.libis_), source_(std::exchange(other.source_, nullptr)) {}
+
+    Source &operator=(Source &&other) noexcept {
+        if (this != &other) {
+            libis_source_destroy(libis_, &source_);
+            libis_ = other.libis_;
+            source_ = std::exchange(other.source_, nullptr);
+        }
+        return *this;
+    }
+
+    LibisSource *get() const noexcept { return source_; }
+
+    // Give up ownership of LibisSource.
+    LibisSource *release() noexcept { return std::exchange(source_, nullptr); }
+
+    // Read dst.size() bytes at offset. Safe to call from many threads at once. See libis_read_at().
+    void read_at(std::uint64_t offset, std::span<std::byte> dst) const {
+        bool eof;
+        check(libis_read_at(libis_, source_, &eof, offset, reinterpret_cast<char *>(dst.data()), dst.size()));
+        if (eof) {
+            throw EndOfStream();
+        }
+    }
+
+    // Read T stored in byte order E at offset.
+    template<Readable T, std::endian E = std::endian::little>
+    T read_at(std::uint64_t offset) const {
+        std::byte bytes[sizeof(T)];
+        read_at(offset, bytes);
+        return load<T, E>(bytes);
+    }
+
+private:
+    Source(Libis *libis, LibisSource *source) noexcept : libis_(libis), source_(source) {}
+
+    Libis *libis_ = nullptr;
+    LibisSource *source_ = nullptr;
+};
+
+// Owner of LibisInputStream. Context must outlive it.
+class Stream {
+public:
+    // Input iterator over bytes of stream usable with standard algorithms.
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::byte;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::byte *;
+        using reference = const std::byte &;
+
+        // Keeps a byte for *it++.
+        struct Proxy {
+            std::byte value;
+            std::byte operator*() const noexcept { return value; }
+        };
+
+        Iterator() = default;
+
+        explicit Iterator(Stream *stream) noexcept : stream_(stream) {}
+
+        reference operator*() const {
+            stream_->at_end();
+            return *stream_->cur_;
+        }
+
+        Iterator &operator++() {
+            if (!stream_->at_end()) {
+                ++stream_->cur_;
+            }
+            return *this;
+        }
+
+        Proxy operator++(int) {
+            Proxy proxy{ **this };
+            ++*this;
+            return proxy;
+        }
+
+        // All iterators of a stream which didn't reach its end are equal.
+        friend bool operator==(const Iterator &a, const Iterator &b) { return a.at_end() == b.at_end(); }
+
+        friend bool operator==(const Iterator &a, std::default_sentinel_t) { return a.at_end(); }
+
+    private:
+        bool at_end() const { return !stream_ || stream_->at_end(); }
+
+        Stream *stream_ = nullptr;
+    };
+
+    Stream(Context &context, Source &&source, std::size_t lookahead = LIBIS_LOOKAHEAD_MIN)
+            : libis_(context.get()) {
+        LibisSource *libis_source = source.release();
+        LibisError err = libis_create(libis_, &input_, &libis_source, lookahead);
+        if (err != LIBIS_ERROR_OK) {
+            libis_source_destroy(libis_, &libis_source);
+            throw Error(err);
+        }
+    }
+
+    ~Stream() {
+        if (input_) {
+            libis_destroy(libis_, &input_);
+        }
+    }
+
+    Stream(const Stream &) = delete;
+    Stream &operator=(const Stream &) = delete;
+
+    Stream(Stream &&other) noexcept
+            : libis_(other.libis_), input_(std::exchange(other.input_, nullptr)),
+              begin_(std::exchange(other.begin_, nullptr)), cur_(std::exchange(other.cur_, nullptr)),
+              end_(std::exchange(other.end_, nullptr)) {}
+
+    Stream &operator=(Stream &&other) noexcept {
+        if (this != &other) {
+            if (input_) {
+                libis_destroy(libis_, &input_);
+            }
+            libis_ = other.libis_;
+            input_ = std::exchange(other.input_, nullptr);
+            begin_ = std::exchange(other.begin_, nullptr);
+            cur_ = std::exchange(other.cur_, nullptr);
+            end_ = std::exchange(other.end_, nullptr);
+        }
+        return *this;
+    }
+
+    // Get LibisInputStream for calling C functions on it directly.
+    // Bytes read through the wrapper get consumed first.
+    LibisInputStream *get() {
+        sync();
+        begin_ = cur_ = end_ = nullptr;
+        return input_;
+    }
+
+    // Read T stored in byte order E or return false without consuming anything if input ends before it.
+    template<Readable T, std::endian E = std::endian::little>
+    bool try_read(T &out) {
+        if (static_cast<std::size_t>(end_ - cur_) < sizeof(T) && !fill(sizeof(T))) {
+            return false;
+        }
+        out = load<T, E>(cur_);
+        cur_ += sizeof(T);
+        return true;
+    }
+
+    // Read T stored in byte order E. Throws EndOfStream if input ends before it.
+    template<Readable T, std::endian E = std::endian::little>
+    T read() {
+        T value;
+        if (!try_read<T, E>(value)) {
+            throw EndOfStream();
+        }
+        return value;
+    }
+
+    // View next size bytes without consuming them. The view is shorter if input ends earlier.
+    // It stays valid until the next call which reads from the stream.
+    std::span<const std::byte> peek(std::size_t size) {
+        if (static_cast<std::size_t>(end_ - cur_) < size) {
+            fill(size);
+        }
+        std::size_t available = static_cast<std::size_t>(end_ - cur_);
+        return { cur_, size < available ? size : available };
+    }
+
+    // View next size bytes and consume them. Throws EndOfStream if input ends before them.
+    // The view stays valid until the next call which reads from the stream.
+    std::span<const std::byte> read_span(std::size_t size) {
+        std::span<const std::byte> view = peek(size);
+        if (view.size() < size) {
+            throw EndOfStream();
+        }
+        cur_ += size;
+        return view;
+    }
+
+    // Consume next size bytes. Throws EndOfStream if input ends before them.
+    void skip(std::size_t size) {
+        while (size) {
+            if (cur_ == end_ && !fill(1)) {
+                throw EndOfStream();
+            }
+            std::size_t n = static_cast<std::size_t>(end_ - cur_);
+            n = size < n ? size : n;
+            cur_ += n;
+            size -= n;
+        }
+    }
+
+    // Whether all bytes of input are consumed.
+    bool at_end() { return cur_ == end_ && !fill(1) && cur_ == end_; }
+
+    Iterator begin() noexcept { return Iterator(this); }
+
+    Iterator end() noexcept { return Iterator(); }
+
+private:
+    // Let the C library know about bytes consumed from the window.
+    void sync() {
+        if (cur_ != begin_) {
+            check(libis_consume(libis_, input_, static_cast<std::size_t>(cur_ - begin_)));
+            begin_ = cur_;
+        }
+    }
+
+    // Make window hold at least size bytes. Returns false if input ends earlier.
+    bool fill(std::size_t size) {
+        bool eof;
+        const char *window;
+        std::size_t available;
+        sync();
+        begin_ = cur_ = end_ = nullptr;
+        check(libis_peek(libis_, input_, &eof, size, &window, &available));
+        begin_ = cur_ = reinterpret_cast<const std::byte *>(window);
+        end_ = begin_ + available;
+        return !eof;
+    }
+
+    Libis *libis_ = nullptr;
+    LibisInputStream *input_ = nullptr;
+    const std::byte *begin_ = nullptr; // Start of window not yet consumed in C library
+    const std::byte *cur_ = nullptr; // Next byte to read
+    const std::byte *end_ = nullptr; // End of window
+};
+
+} // namespace libis
+
+#endif
@@ -5,22 +5,6 @@
 
 #include "libis_internal.h"
 
-struct Libis_ {
-    int dummy;
-};
-
-// Bytes get read lazily from source into the buffer usually one by one.
-// The buffer is only required for lookahead. When the user needs to
-// look ahead by n bytes, n bytes get read into the buffer. Subsequent
-// libis_read_* calls first consume bytes from the buffer.
-struct LibisInputStream_ {
-    LibisSource *source;
-    char *buffer;
-    size_t buffer_size; // Number of bytes filled into buffer
-    size_t buffer_capacity; // Buffer length
-    unsigned bit_offset; // Bit offset from start of buffer (always less than CHAR_BIT)
-};
-
 LibisError libis_handle_internal_error(LibisError err) {
     switch (err) {
     case LIBIS_ERROR_OK:
@@ -35,6 +19,12 @@ LibisError libis_handle_internal_error(LibisError err) {
         return LIBIS_ERROR_TOO_FAR;
     case LIBIS_ERROR_HANGING_BITS:
         return LIBIS_ERROR_HANGING_BITS;
+    case LIBIS_ERROR_NOT_SUPPORTED:
+        return LIBIS_ERROR_NOT_SUPPORTED;
+    case LIBIS_ERROR_MALFORMED:
+        return LIBIS_ERROR_MALFORMED;
+    case LIBIS_ERROR_OUT_OF_RANGE:
+        return LIBIS_ERROR_OUT_OF_RANGE;
     }
     abort();
 }
@@ -51,6 +41,7 @@ LibisError libis_start(Libis **libis) {
         err = LIBIS_ERROR_OUT_OF_MEMORY;
         goto end;
     }
+    libis_checksum_init(result);
     *libis = result;
     result = NULL;
 end:
@@ -86,18 +77,155 @@ end:
     return err;
 }
 
+LibisError libis_read_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, char *dst, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !source || !eof || (!dst && size)) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    if (!source->read_at) {
+        err = LIBIS_ERROR_NOT_SUPPORTED;
+        goto end;
+    }
+    err = E(source->read_at(libis, source, eof, offset, dst, size));
+end:
+    return err;
+}
+
+LibisError libis_read_u8_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint8_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint8_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = (uint8_t) bytes[0];
+end:
+    return err;
+}
+
+LibisError libis_read_u16_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint16_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint16_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u16_le(bytes);
+end:
+    return err;
+}
+
+LibisError libis_read_u16_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint16_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint16_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u16_be(bytes);
+end:
+    return err;
+}
+
+LibisError libis_read_u32_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint32_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint32_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u32_le(bytes);
+end:
+    return err;
+}
+
+LibisError libis_read_u32_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint32_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint32_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u32_be(bytes);
+end:
+    return err;
+}
+
+LibisError libis_read_u64_le_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint64_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u64_le(bytes);
+end:
+    return err;
+}
+
+LibisError libis_read_u64_be_at(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, uint64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    char bytes[sizeof(uint64_t)];
+    if (!libis || !source || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_at(libis, source, eof, offset, bytes, sizeof(bytes)));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = libis_load_u64_be(bytes);
+end:
+    return err;
+}
+
 LibisError libis_create(Libis *libis, LibisInputStream **input, LibisSource **source, size_t lookahead) {
     LibisError err = LIBIS_ERROR_OK;
     LibisInputStream *result = NULL;
     char *buffer = NULL;
+    size_t capacity;
     if (!libis || !input || !source) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
-    if (lookahead < 2) {
-        lookahead = 2;
+    if (lookahead < LIBIS_LOOKAHEAD_MIN) {
+        lookahead = LIBIS_LOOKAHEAD_MIN;
     }
-    buffer = malloc(lookahead);
+    capacity = lookahead < LIBIS_BLOCK_SIZE ? LIBIS_BLOCK_SIZE : lookahead;
+    buffer = malloc(capacity);
     if (!buffer) {
         err = LIBIS_ERROR_OUT_OF_MEMORY;
         goto end;
@@ -109,9 +237,17 @@ LibisError libis_create(Libis *libis, LibisInputStream **input, LibisSource **so
     }
     result->source = *source;
     result->buffer = buffer;
+    result->buffer_offset = 0;
     result->buffer_size = 0;
-    result->buffer_capacity = lookahead;
+    result->buffer_capacity = capacity;
+    result->lookahead = lookahead;
     result->bit_offset = 0;
+    result->observed = 0;
+    result->checksum_enabled = false;
+    result->discarded = 0;
+    result->position_enabled = false;
+    result->line = 1;
+    result->column = 1;
     *input = result;
     *source = NULL;
     buffer = NULL;
@@ -138,9 +274,20 @@ end:
     return err;
 }
 
-// Fill buffer with at least length bytes from source.
-static LibisError libis_prepare_block(Libis *libis, LibisInputStream *input, bool *eof, size_t size) {
+void libis_observe_consumed(Libis *libis, LibisInputStream *input) {
+    if (input->checksum_enabled) {
+        libis_checksum_update(libis, &input->checksum,
+                input->buffer + input->observed, input->buffer_offset - input->observed);
+    }
+    if (input->position_enabled) {
+        libis_position_update(input, input->buffer + input->observed, input->buffer_offset - input->observed);
+    }
+    input->observed = input->buffer_offset;
+}
+
+LibisError libis_fill(Libis *libis, LibisInputStream *input, bool *eof, size_t size) {
     LibisError err = LIBIS_ERROR_OK;
+    size_t nread;
     if (!libis || !input) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
@@ -150,13 +297,103 @@ static LibisError libis_prepare_block(Libis *libis, LibisInputStream *input, boo
         err = LIBIS_ERROR_TOO_FAR;
         goto end;
     }
-    while (input->buffer_size < size) {
-        err = input->source->read(libis, input->source, eof, &input->buffer[input->buffer_size]);
+    if (size <= input->buffer_size - input->buffer_offset) {
+        goto end;
+    }
+    if (input->buffer_capacity - input->buffer_offset < size) {
+        libis_observe_consumed(libis, input);
+        memmove(input->buffer, input->buffer + input->buffer_offset, input->buffer_size - input->buffer_offset);
+        input->buffer_size -= input->buffer_offset;
+        input->discarded += input->buffer_offset;
+        input->buffer_offset = 0;
+        input->observed = 0;
+    }
+    while (input->buffer_size - input->buffer_offset < size) {
+        err = input->source->read(libis, input->source, eof, input->buffer + input->buffer_size,
+                size - (input->buffer_size - input->buffer_offset), input->buffer_capacity - input->buffer_size,
+                &nread);
+        if (*eof || err) {
+            goto end;
+        }
+        input->buffer_size += nread;
+    }
+end:
+    return err;
+}
+
+LibisError libis_skip_bytes(Libis *libis, LibisInputStream *input, bool *eof, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t n;
+    if (!libis || !input || !eof) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    while (size) {
+        err = E(libis_fill(libis, input, eof, 1));
         if (*eof || err) {
             goto end;
         }
-        ++input->buffer_size;
+        n = input->buffer_size - input->buffer_offset;
+        if (size < n) {
+            n = size;
+        }
+        input->buffer_offset += n;
+        size -= n;
+    }
+end:
+    return err;
+}
+
+// Fill buffer with at least size bytes from source respecting lookahead limit.
+static LibisError libis_prepare_block(Libis *libis, LibisInputStream *input, bool *eof, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    if (input->lookahead < size) {
+        err = LIBIS_ERROR_TOO_FAR;
+        goto end;
+    }
+    err = E(libis_fill(libis, input, eof, size));
+end:
+    return err;
+}
+
+LibisError libis_peek(
+        Libis *libis, LibisInputStream *input, bool *eof, size_t size, const char **window, size_t *available) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input || !eof || !window || !available) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    err = E(libis_fill(libis, input, eof, size));
+end:
+    if (input && window && available) {
+        *window = input->buffer + input->buffer_offset;
+        *available = input->buffer_size - input->buffer_offset;
+    }
+    return err;
+}
+
+LibisError libis_consume(Libis *libis, LibisInputStream *input, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input || input->buffer_size - input->buffer_offset < size) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
     }
+    input->buffer_offset += size;
 end:
     return err;
 }
@@ -172,7 +409,7 @@ LibisError libis_lookahead(Libis *libis, LibisInputStream *input, bool *eof, siz
     if (*eof || err) {
         goto end;
     }
-    *out = input->buffer[offset - 1];
+    *out = input->buffer[input->buffer_offset + offset - 1];
 end:
     return err;
 }
@@ -206,10 +443,9 @@ LibisError libis_read_char(Libis *libis, LibisInputStream *input, bool *eof, cha
     if (*eof || err) {
         goto end;
     }
-    *out = input->buffer[0];
-    assert(input->buffer_size > 0);
-    memmove(input->buffer, input->buffer + 1, input->buffer_size - 1);
-    --input->buffer_size;
+    assert(input->buffer_offset < input->buffer_size);
+    *out = input->buffer[input->buffer_offset];
+    ++input->buffer_offset;
 end:
     return err;
 }
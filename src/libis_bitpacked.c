@@ -0,0 +1,365 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "libis_internal.h"
+
+#if defined(__GNUC__)
+#define LIBIS_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define LIBIS_ALWAYS_INLINE inline
+#endif
+
+// Values are unpacked in groups of 8. A group of 8 values of width bits takes exactly width bytes
+// so groups never share bytes and can be unpacked straight from the stream buffer.
+#define LIBIS_GROUP 8
+
+// Expand f for widths from base + 1 to base + 8.
+#define LIBIS_WIDTHS_8(f, base) \
+    f(base + 1) f(base + 2) f(base + 3) f(base + 4) f(base + 5) f(base + 6) f(base + 7) f(base + 8)
+
+// Unpack a group of values of width bits from width bytes at in.
+// Always inlined and called with constant width so that every width gets its own kernel
+// with constant shifts and masks the compiler is free to vectorize.
+static LIBIS_ALWAYS_INLINE void libis_unpack_group_u32(
+        const unsigned char *in, unsigned width, uint32_t *out) {
+    uint64_t mask = ((uint64_t) 1 << width) - 1;
+    for (unsigned i = 0; i < LIBIS_GROUP; ++i) {
+        unsigned bit = i * width;
+        unsigned shift = bit % CHAR_BIT;
+        const unsigned char *p = in + bit / CHAR_BIT;
+        uint64_t word = 0;
+        for (unsigned j = 0; j * CHAR_BIT < shift + width; ++j) {
+            word |= (uint64_t) p[j] << (j * CHAR_BIT);
+        }
+        out[i] = (uint32_t) (word >> shift & mask);
+    }
+}
+
+// see libis_unpack_group_u32
+static LIBIS_ALWAYS_INLINE void libis_unpack_group_u64(
+        const unsigned char *in, unsigned width, uint64_t *out) {
+    uint64_t mask = width < 64 ? ((uint64_t) 1 << width) - 1 : UINT64_MAX;
+    for (unsigned i = 0; i < LIBIS_GROUP; ++i) {
+        unsigned bit = i * width;
+        unsigned shift = bit % CHAR_BIT;
+        const unsigned char *p = in + bit / CHAR_BIT;
+        uint64_t word = 0;
+        for (unsigned j = 0; j < sizeof(uint64_t) && j * CHAR_BIT < shift + width; ++j) {
+            word |= (uint64_t) p[j] << (j * CHAR_BIT);
+        }
+        word >>= shift;
+        if (64 < shift + width) {
+            word |= (uint64_t) p[sizeof(uint64_t)] << (64 - shift);
+        }
+        out[i] = word & mask;
+    }
+}
+
+#define LIBIS_UNPACK_CASE_U32(width) \
+    case width: \
+        for (size_t g = 0; g < groups; ++g) { \
+            libis_unpack_group_u32(in + g * (width), width, out + g * LIBIS_GROUP); \
+        } \
+        break;
+
+#define LIBIS_UNPACK_CASE_U64(width) \
+    case width: \
+        for (size_t g = 0; g < groups; ++g) { \
+            libis_unpack_group_u64(in + g * (width), width, out + g * LIBIS_GROUP); \
+        } \
+        break;
+
+// Unpack groups of values dispatching to the kernel specialized for width.
+static void libis_unpack_u32(const char *bytes, unsigned width, uint32_t *out, size_t groups) {
+    const unsigned char *in = (const unsigned char *) bytes;
+    switch (width) {
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U32, 0)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U32, 8)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U32, 16)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U32, 24)
+    }
+}
+
+// see libis_unpack_u32
+static void libis_unpack_u64(const char *bytes, unsigned width, uint64_t *out, size_t groups) {
+    const unsigned char *in = (const unsigned char *) bytes;
+    switch (width) {
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 0)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 8)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 16)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 24)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 32)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 40)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 48)
+    LIBIS_WIDTHS_8(LIBIS_UNPACK_CASE_U64, 56)
+    }
+}
+
+LibisError libis_read_bitpacked_u32(
+        Libis *libis, LibisInputStream *input, bool *eof, unsigned bit_width, uint32_t *out, size_t count) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t groups, nbytes;
+    char tail[32 + 1] = { 0 }; // Bytes of the last incomplete group padded with zeros
+    uint32_t values[LIBIS_GROUP];
+    if (!libis || !input || !eof || (!out && count) || !bit_width || 32 < bit_width) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    while (LIBIS_GROUP <= count) {
+        err = E(libis_fill(libis, input, eof, bit_width));
+        if (*eof || err) {
+            goto end;
+        }
+        groups = (input->buffer_size - input->buffer_offset) / bit_width;
+        if (count / LIBIS_GROUP < groups) {
+            groups = count / LIBIS_GROUP;
+        }
+        libis_unpack_u32(input->buffer + input->buffer_offset, bit_width, out, groups);
+        input->buffer_offset += groups * bit_width;
+        out += groups * LIBIS_GROUP;
+        count -= groups * LIBIS_GROUP;
+    }
+    if (count) {
+        nbytes = (count * bit_width + CHAR_BIT - 1) / CHAR_BIT;
+        err = E(libis_fill(libis, input, eof, nbytes));
+        if (*eof || err) {
+            goto end;
+        }
+        memcpy(tail, input->buffer + input->buffer_offset, nbytes);
+        input->buffer_offset += nbytes;
+        libis_unpack_u32(tail, bit_width, values, 1);
+        memcpy(out, values, count * sizeof(uint32_t));
+    }
+end:
+    return err;
+}
+
+LibisError libis_read_bitpacked_u64(
+        Libis *libis, LibisInputStream *input, bool *eof, unsigned bit_width, uint64_t *out, size_t count) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t groups, nbytes;
+    char tail[64 + 1] = { 0 }; // Bytes of the last incomplete group padded with zeros
+    uint64_t values[LIBIS_GROUP];
+    if (!libis || !input || !eof || (!out && count) || !bit_width || 64 < bit_width) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    while (LIBIS_GROUP <= count) {
+        err = E(libis_fill(libis, input, eof, bit_width));
+        if (*eof || err) {
+            goto end;
+        }
+        groups = (input->buffer_size - input->buffer_offset) / bit_width;
+        if (count / LIBIS_GROUP < groups) {
+            groups = count / LIBIS_GROUP;
+        }
+        libis_unpack_u64(input->buffer + input->buffer_offset, bit_width, out, groups);
+        input->buffer_offset += groups * bit_width;
+        out += groups * LIBIS_GROUP;
+        count -= groups * LIBIS_GROUP;
+    }
+    if (count) {
+        nbytes = (count * bit_width + CHAR_BIT - 1) / CHAR_BIT;
+        err = E(libis_fill(libis, input, eof, nbytes));
+        if (*eof || err) {
+            goto end;
+        }
+        memcpy(tail, input->buffer + input->buffer_offset, nbytes);
+        input->buffer_offset += nbytes;
+        libis_unpack_u64(tail, bit_width, values, 1);
+        memcpy(out, values, count * sizeof(uint64_t));
+    }
+end:
+    return err;
+}
+
+// State of RLE/bit-packing hybrid decoding kept between calls so that runs may span them.
+struct LibisRleDecoder_ {
+    unsigned bit_width;
+    bool bitpacked; // Whether the current run is bit-packed
+    size_t remaining; // Number of values of the current run left in input stream
+    uint32_t value; // Value repeated by the current RLE run
+    uint32_t group[LIBIS_GROUP]; // Unpacked group of bit-packed run
+    size_t group_offset; // Index of the next value to return from group
+};
+
+// Read unsigned LEB128 varint used for run headers.
+static LibisError libis_read_uleb128_u32(Libis *libis, LibisInputStream *input, bool *eof, uint32_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    uint8_t byte;
+    unsigned shift = 0;
+    *out = 0;
+    do {
+        if (32 <= shift) {
+            err = LIBIS_ERROR_MALFORMED;
+            goto end;
+        }
+        err = E(libis_read_u8(libis, input, eof, &byte));
+        if (*eof || err) {
+            goto end;
+        }
+        *out |= (uint32_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+end:
+    return err;
+}
+
+LibisError libis_rle_decoder_create(Libis *libis, LibisRleDecoder **decoder, unsigned bit_width) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisRleDecoder *result = NULL;
+    if (!libis || !decoder || 32 < bit_width) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    result = malloc(sizeof(LibisRleDecoder));
+    if (!result) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    result->bit_width = bit_width;
+    *decoder = result;
+    E(libis_rle_decoder_reset(libis, result));
+end:
+    return err;
+}
+
+LibisError libis_rle_decoder_destroy(Libis *libis, LibisRleDecoder **decoder) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !decoder) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    free(*decoder);
+    *decoder = NULL;
+end:
+    return err;
+}
+
+LibisError libis_rle_decoder_reset(Libis *libis, LibisRleDecoder *decoder) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !decoder) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    decoder->bitpacked = false;
+    decoder->remaining = 0;
+    decoder->value = 0;
+    decoder->group_offset = LIBIS_GROUP;
+end:
+    return err;
+}
+
+// Read header of the next run and value of RLE run into decoder.
+static LibisError libis_rle_decoder_start_run(
+        Libis *libis, LibisInputStream *input, bool *eof, LibisRleDecoder *decoder) {
+    LibisError err = LIBIS_ERROR_OK;
+    uint32_t header;
+    size_t nbytes;
+    err = E(libis_read_uleb128_u32(libis, input, eof, &header));
+    if (*eof || err) {
+        goto end;
+    }
+    decoder->bitpacked = header & 1;
+    if (decoder->bitpacked) {
+        // Bit-packed run of header >> 1 groups of 8 values.
+        decoder->remaining = (size_t) (header >> 1) * LIBIS_GROUP;
+        goto end;
+    }
+    // RLE run of header >> 1 repetitions of a value stored in ceil(bit_width / 8) bytes.
+    nbytes = (decoder->bit_width + CHAR_BIT - 1) / CHAR_BIT;
+    err = E(libis_fill(libis, input, eof, nbytes));
+    if (*eof || err) {
+        goto end;
+    }
+    decoder->value = 0;
+    for (size_t i = 0; i < nbytes; ++i) {
+        decoder->value |= (uint32_t) (unsigned char) input->buffer[input->buffer_offset + i] << (i * CHAR_BIT);
+    }
+    input->buffer_offset += nbytes;
+    decoder->remaining = header >> 1;
+end:
+    return err;
+}
+
+// Unpack count values of bit-packed run where count is a multiple of 8.
+static LibisError libis_rle_decoder_unpack(Libis *libis, LibisInputStream *input, bool *eof,
+        const LibisRleDecoder *decoder, uint32_t *out, size_t count) {
+    if (!decoder->bit_width) {
+        *eof = false;
+        memset(out, 0, count * sizeof(uint32_t));
+        return LIBIS_ERROR_OK;
+    }
+    return E(libis_read_bitpacked_u32(libis, input, eof, decoder->bit_width, out, count));
+}
+
+LibisError libis_read_rle_bitpacked_hybrid_u32(Libis *libis, LibisInputStream *input, bool *eof,
+        LibisRleDecoder *decoder, uint32_t *out, size_t count, size_t *nread) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t n;
+    if (!libis || !input || !eof || !decoder || (!out && count) || !nread) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *nread = 0;
+    while (*nread < count) {
+        n = count - *nread;
+        if (decoder->group_offset < LIBIS_GROUP) {
+            // Values left from a group unpacked by the previous call
+            if (LIBIS_GROUP - decoder->group_offset < n) {
+                n = LIBIS_GROUP - decoder->group_offset;
+            }
+            memcpy(out + *nread, decoder->group + decoder->group_offset, n * sizeof(uint32_t));
+            decoder->group_offset += n;
+        } else if (!decoder->remaining) {
+            err = E(libis_rle_decoder_start_run(libis, input, eof, decoder));
+            if (*eof || err) {
+                goto end;
+            }
+            continue;
+        } else if (!decoder->bitpacked) {
+            if (decoder->remaining < n) {
+                n = decoder->remaining;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                out[*nread + i] = decoder->value;
+            }
+            decoder->remaining -= n;
+        } else if (LIBIS_GROUP <= n) {
+            // Whole groups get unpacked straight into out.
+            n = n / LIBIS_GROUP * LIBIS_GROUP;
+            if (decoder->remaining < n) {
+                n = decoder->remaining;
+            }
+            err = E(libis_rle_decoder_unpack(libis, input, eof, decoder, out + *nread, n));
+            if (*eof || err) {
+                goto end;
+            }
+            decoder->remaining -= n;
+        } else {
+            // Group is split between calls so keep it in decoder.
+            err = E(libis_rle_decoder_unpack(libis, input, eof, decoder, decoder->group, LIBIS_GROUP));
+            if (*eof || err) {
+                goto end;
+            }
+            decoder->remaining -= LIBIS_GROUP;
+            decoder->group_offset = 0;
+            continue;
+        }
+        *nread += n;
+    }
+end:
+    return err;
+}
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <libis.h>
@@ -15,26 +16,49 @@ typedef struct {
 } LibisBufferSource;
 
 // see LibisSource::read
-static LibisError libis_buffer_source_read(Libis *libis, LibisSource *source, bool *eof, char *c) {
+static LibisError libis_buffer_source_read(Libis *libis, LibisSource *source, bool *eof,
+        char *dst, size_t min_size, size_t size, size_t *nread) {
     LibisError err = LIBIS_ERROR_OK;
     LibisBufferSource *buffer_source = (LibisBufferSource *) source;
-    if (!libis || !source) {
+    if (!libis || !source || !eof || !dst || !min_size || size < min_size || !nread) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
     assert(buffer_source->offset <= buffer_source->size);
+    *nread = 0;
     if (buffer_source->offset == buffer_source->size) {
         *eof = true;
-        *c = '\0';
         goto end;
     }
-    *c = buffer_source->buffer[buffer_source->offset];
-    ++buffer_source->offset;
+    if (buffer_source->size - buffer_source->offset < size) {
+        size = buffer_source->size - buffer_source->offset;
+    }
+    memcpy(dst, buffer_source->buffer + buffer_source->offset, size);
+    buffer_source->offset += size;
+    *nread = size;
     *eof = false;
 end:
     return err;
 }
 
+// see LibisSource::read_at
+static LibisError libis_buffer_source_read_at(
+        Libis *libis, LibisSource *source, bool *eof, uint64_t offset, char *dst, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisBufferSource *buffer_source = (LibisBufferSource *) source;
+    if (!libis || !source || !eof) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = buffer_source->size < offset || buffer_source->size - offset < size;
+    if (*eof) {
+        goto end;
+    }
+    memcpy(dst, buffer_source->buffer + offset, size);
+end:
+    return err;
+}
+
 // see LibisSource::free
 static LibisError libis_buffer_source_free(Libis *libis, LibisSource *source) {
     LibisError err = LIBIS_ERROR_OK;
@@ -64,6 +88,7 @@ LibisError libis_source_create_from_buffer(
         goto end;
     }
     buffer_source->source.read = libis_buffer_source_read;
+    buffer_source->source.read_at = libis_buffer_source_read_at;
     buffer_source->source.free = libis_buffer_source_free;
     buffer_source->buffer = buffer;
     buffer_source->size = size;
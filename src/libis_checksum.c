@@ -0,0 +1,235 @@
+#include <string.h>
+
+#include "libis_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIBIS_HAVE_SSE42_CRC32C
+#include <nmmintrin.h>
+#endif
+
+// Reflected polynomials
+#define LIBIS_CRC32_POLYNOMIAL 0xEDB88320u
+#define LIBIS_CRC32C_POLYNOMIAL 0x82F63B78u
+
+// XXH64 primes
+#define LIBIS_XXH_PRIME1 0x9E3779B185EBCA87u
+#define LIBIS_XXH_PRIME2 0xC2B2AE3D27D4EB4Fu
+#define LIBIS_XXH_PRIME3 0x165667B19E3779F9u
+#define LIBIS_XXH_PRIME4 0x85EBCA77C2B2AE63u
+#define LIBIS_XXH_PRIME5 0x27D4EB2F165667C5u
+
+// Table k maps byte b to CRC of b followed by k zero bytes which lets
+// slicing-by-8 process 8 bytes with 8 independent lookups.
+static void libis_crc_init_table(uint32_t table[8][256], uint32_t polynomial) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int j = 0; j < CHAR_BIT; ++j) {
+            crc = crc & 1 ? crc >> 1 ^ polynomial : crc >> 1;
+        }
+        table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int k = 1; k < 8; ++k) {
+            table[k][i] = table[k - 1][i] >> 8 ^ table[0][table[k - 1][i] & 0xFF];
+        }
+    }
+}
+
+void libis_checksum_init(Libis *libis) {
+    libis_crc_init_table(libis->crc32_table, LIBIS_CRC32_POLYNOMIAL);
+    libis_crc_init_table(libis->crc32c_table, LIBIS_CRC32C_POLYNOMIAL);
+#if defined(LIBIS_HAVE_SSE42_CRC32C)
+    libis->crc32c_hardware = __builtin_cpu_supports("sse4.2");
+#else
+    libis->crc32c_hardware = false;
+#endif
+}
+
+static uint32_t libis_crc_slicing_by_8(const uint32_t table[8][256], uint32_t crc, const char *p, size_t size) {
+    uint32_t lo, hi;
+    while (8 <= size) {
+        lo = libis_load_u32_le(p) ^ crc;
+        hi = libis_load_u32_le(p + 4);
+        crc = table[7][lo & 0xFF] ^ table[6][lo >> 8 & 0xFF] ^ table[5][lo >> 16 & 0xFF] ^ table[4][lo >> 24]
+                ^ table[3][hi & 0xFF] ^ table[2][hi >> 8 & 0xFF] ^ table[1][hi >> 16 & 0xFF] ^ table[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = table[0][(crc ^ (unsigned char) *p++) & 0xFF] ^ crc >> 8;
+    }
+    return crc;
+}
+
+#if defined(LIBIS_HAVE_SSE42_CRC32C)
+__attribute__((target("sse4.2")))
+static uint32_t libis_crc32c_sse42(uint32_t crc, const char *p, size_t size) {
+#if defined(__x86_64__)
+    uint64_t crc64 = crc, word;
+    while (8 <= size) {
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = (uint32_t) crc64;
+#endif
+    while (size--) {
+        crc = _mm_crc32_u8(crc, (unsigned char) *p++);
+    }
+    return crc;
+}
+#endif
+
+static inline uint64_t libis_rotl64(uint64_t x, unsigned r) {
+    return x << r | x >> (64 - r);
+}
+
+static inline uint64_t libis_xxh64_round(uint64_t accumulator, uint64_t lane) {
+    accumulator += lane * LIBIS_XXH_PRIME2;
+    accumulator = libis_rotl64(accumulator, 31);
+    return accumulator * LIBIS_XXH_PRIME1;
+}
+
+static inline uint64_t libis_xxh64_merge_round(uint64_t hash, uint64_t accumulator) {
+    hash ^= libis_xxh64_round(0, accumulator);
+    return hash * LIBIS_XXH_PRIME1 + LIBIS_XXH_PRIME4;
+}
+
+// Hash whole 32 byte stripes at p and return number of bytes hashed.
+static size_t libis_xxh64_stripes(LibisChecksumState *state, const char *p, size_t size) {
+    uint64_t *v = state->accumulators;
+    size_t hashed = 0;
+    while (32 <= size - hashed) {
+        v[0] = libis_xxh64_round(v[0], libis_load_u64_le(p + hashed));
+        v[1] = libis_xxh64_round(v[1], libis_load_u64_le(p + hashed + 8));
+        v[2] = libis_xxh64_round(v[2], libis_load_u64_le(p + hashed + 16));
+        v[3] = libis_xxh64_round(v[3], libis_load_u64_le(p + hashed + 24));
+        hashed += 32;
+    }
+    return hashed;
+}
+
+static void libis_xxh64_update(LibisChecksumState *state, const char *p, size_t size) {
+    size_t n;
+    state->total += size;
+    if (state->stripe_size) {
+        n = sizeof(state->stripe) - state->stripe_size;
+        n = size < n ? size : n;
+        memcpy(state->stripe + state->stripe_size, p, n);
+        state->stripe_size += n;
+        p += n;
+        size -= n;
+        if (state->stripe_size < sizeof(state->stripe)) {
+            return;
+        }
+        libis_xxh64_stripes(state, state->stripe, sizeof(state->stripe));
+        state->stripe_size = 0;
+    }
+    n = libis_xxh64_stripes(state, p, size);
+    memcpy(state->stripe, p + n, size - n);
+    state->stripe_size = size - n;
+}
+
+static uint64_t libis_xxh64_digest(const LibisChecksumState *state) {
+    const uint64_t *v = state->accumulators;
+    const char *p = state->stripe;
+    size_t size = state->stripe_size;
+    uint64_t hash;
+    if (32 <= state->total) {
+        hash = libis_rotl64(v[0], 1) + libis_rotl64(v[1], 7) + libis_rotl64(v[2], 12) + libis_rotl64(v[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            hash = libis_xxh64_merge_round(hash, v[i]);
+        }
+    } else {
+        hash = LIBIS_XXH_PRIME5;
+    }
+    hash += state->total;
+    for (; 8 <= size; p += 8, size -= 8) {
+        hash ^= libis_xxh64_round(0, libis_load_u64_le(p));
+        hash = libis_rotl64(hash, 27) * LIBIS_XXH_PRIME1 + LIBIS_XXH_PRIME4;
+    }
+    if (4 <= size) {
+        hash ^= libis_load_u32_le(p) * LIBIS_XXH_PRIME1;
+        hash = libis_rotl64(hash, 23) * LIBIS_XXH_PRIME2 + LIBIS_XXH_PRIME3;
+        p += 4;
+        size -= 4;
+    }
+    for (; size; ++p, --size) {
+        hash ^= (unsigned char) *p * LIBIS_XXH_PRIME5;
+        hash = libis_rotl64(hash, 11) * LIBIS_XXH_PRIME1;
+    }
+    hash ^= hash >> 33;
+    hash *= LIBIS_XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= LIBIS_XXH_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void libis_checksum_update(Libis *libis, LibisChecksumState *state, const char *p, size_t size) {
+    switch (state->kind) {
+    case LIBIS_CRC32:
+        state->crc = libis_crc_slicing_by_8((const uint32_t (*)[256]) libis->crc32_table, state->crc, p, size);
+        break;
+    case LIBIS_CRC32C:
+#if defined(LIBIS_HAVE_SSE42_CRC32C)
+        if (libis->crc32c_hardware) {
+            state->crc = libis_crc32c_sse42(state->crc, p, size);
+            break;
+        }
+#endif
+        state->crc = libis_crc_slicing_by_8((const uint32_t (*)[256]) libis->crc32c_table, state->crc, p, size);
+        break;
+    case LIBIS_XXH64:
+        libis_xxh64_update(state, p, size);
+        break;
+    }
+}
+
+LibisError libis_checksum_begin(Libis *libis, LibisInputStream *input, LibisChecksumKind kind) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisChecksumState *state;
+    if (!libis || !input || (kind != LIBIS_CRC32 && kind != LIBIS_CRC32C && kind != LIBIS_XXH64)) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    libis_observe_consumed(libis, input);
+    state = &input->checksum;
+    state->kind = kind;
+    state->crc = UINT32_MAX;
+    state->accumulators[0] = LIBIS_XXH_PRIME1 + LIBIS_XXH_PRIME2;
+    state->accumulators[1] = LIBIS_XXH_PRIME2;
+    state->accumulators[2] = 0;
+    state->accumulators[3] = 0 - LIBIS_XXH_PRIME1;
+    state->total = 0;
+    state->stripe_size = 0;
+    input->checksum_enabled = true;
+end:
+    return err;
+}
+
+LibisError libis_checksum_end(Libis *libis, LibisInputStream *input, uint64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input || !out || !input->checksum_enabled) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    libis_observe_consumed(libis, input);
+    input->checksum_enabled = false;
+    if (input->checksum.kind == LIBIS_XXH64) {
+        *out = libis_xxh64_digest(&input->checksum);
+    } else {
+        *out = input->checksum.crc ^ UINT32_MAX;
+    }
+end:
+    return err;
+}
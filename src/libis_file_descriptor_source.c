@@ -1,56 +1,253 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
-#include "libis_source.h"
+#include "libis_internal.h"
+
+// Alignment of memory, file offsets and lengths required for O_DIRECT reads.
+#define LIBIS_DIRECT_ALIGNMENT 4096
+
+// Positional O_DIRECT reads which fit into this many bytes bounce through the stack.
+#define LIBIS_DIRECT_STACK_SIZE (2 * LIBIS_DIRECT_ALIGNMENT)
+
+// Number of read bytes which get dropped from page cache at once.
+#define LIBIS_DROP_BEHIND_SIZE (16 * LIBIS_BLOCK_SIZE)
+
+// Number of already dropped bytes which get dropped again. The kernel keeps large folios of
+// page cache which are not wholly inside the dropped range so consecutive ranges must overlap.
+#define LIBIS_DROP_BEHIND_OVERLAP (8 * 1024 * 1024)
 
 // LibisSource for a file descriptor
 typedef struct {
     LibisSource source;
     int file_descriptor;
+    unsigned flags; // LibisFileDescriptorFlags which are in effect
+    off_t offset; // File offset of the next byte to read from file descriptor
+    off_t dropped; // File offset up to which read bytes were dropped from page cache
+    char *block; // Aligned buffer for O_DIRECT reads
+    size_t block_offset; // Read position inside block
+    size_t block_size; // Number of bytes filled into block
 } LibisFileDescriptorSource;
 
+// Stop using O_DIRECT and continue reading through the page cache.
+static void libis_file_descriptor_source_disable_direct(LibisFileDescriptorSource *file_descriptor_source) {
+    int status_flags = fcntl(file_descriptor_source->file_descriptor, F_GETFL);
+    if (0 <= status_flags) {
+        fcntl(file_descriptor_source->file_descriptor, F_SETFL, status_flags & ~O_DIRECT);
+    }
+    file_descriptor_source->flags &= ~LIBIS_FD_DIRECT;
+}
+
+// Drop read bytes from page cache. to_end drops the rest of file too once reading is over.
+static void libis_file_descriptor_source_drop_behind(
+        LibisFileDescriptorSource *file_descriptor_source, bool to_end) {
+    off_t start = file_descriptor_source->dropped - LIBIS_DROP_BEHIND_OVERLAP;
+    if (start < 0) {
+        start = 0;
+    }
+    // Advice only: errors are ignored as the data was read anyway.
+    posix_fadvise(file_descriptor_source->file_descriptor, start,
+            to_end ? 0 : file_descriptor_source->offset - start, POSIX_FADV_DONTNEED);
+    file_descriptor_source->dropped = file_descriptor_source->offset;
+}
+
+// Read from file descriptor retrying on interrupts and account read bytes for drop behind.
+static ssize_t libis_file_descriptor_source_read_raw(
+        LibisFileDescriptorSource *file_descriptor_source, char *dst, size_t size) {
+    ssize_t n;
+    do {
+        n = read(file_descriptor_source->file_descriptor, dst, size);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return n;
+    }
+    file_descriptor_source->offset += n;
+    if (!(file_descriptor_source->flags & LIBIS_FD_DROP_BEHIND)) {
+        return n;
+    }
+    if (!n && file_descriptor_source->dropped < file_descriptor_source->offset) {
+        // Drop the tail shorter than LIBIS_DROP_BEHIND_SIZE at end of file.
+        libis_file_descriptor_source_drop_behind(file_descriptor_source, true);
+    } else if (LIBIS_DROP_BEHIND_SIZE <= file_descriptor_source->offset - file_descriptor_source->dropped) {
+        libis_file_descriptor_source_drop_behind(file_descriptor_source, false);
+    }
+    return n;
+}
+
+// Refill aligned block with O_DIRECT. Falls back to page cache if file system refuses direct reads.
+static ssize_t libis_file_descriptor_source_read_block(LibisFileDescriptorSource *file_descriptor_source) {
+    ssize_t n;
+    if (file_descriptor_source->offset % LIBIS_DIRECT_ALIGNMENT) {
+        libis_file_descriptor_source_disable_direct(file_descriptor_source);
+    }
+    n = libis_file_descriptor_source_read_raw(file_descriptor_source, file_descriptor_source->block, LIBIS_BLOCK_SIZE);
+    if (n < 0 && errno == EINVAL && (file_descriptor_source->flags & LIBIS_FD_DIRECT)) {
+        libis_file_descriptor_source_disable_direct(file_descriptor_source);
+        n = libis_file_descriptor_source_read_raw(
+                file_descriptor_source, file_descriptor_source->block, LIBIS_BLOCK_SIZE);
+    }
+    file_descriptor_source->block_offset = 0;
+    file_descriptor_source->block_size = n < 0 ? 0 : (size_t) n;
+    return n;
+}
+
 // see LibSource::read
-LibisError libis_file_descriptor_source_read(Libis *libis, LibisSource *source, bool *eof, char *c) {
+static LibisError libis_file_descriptor_source_read(Libis *libis, LibisSource *source, bool *eof,
+        char *dst, size_t min_size, size_t size, size_t *nread) {
     LibisError err = LIBIS_ERROR_OK;
     LibisFileDescriptorSource *file_descriptor_source = (LibisFileDescriptorSource *) source;
-    if (!libis || !source || !eof || !c) {
+    ssize_t n;
+    if (!libis || !source || !eof || !dst || !min_size || size < min_size || !nread) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
     *eof = false;
-    *c = '\0';
-    int n = read(file_descriptor_source->file_descriptor, c, 1);
+    *nread = 0;
+    if (!file_descriptor_source->block) {
+        n = libis_file_descriptor_source_read_raw(file_descriptor_source, dst, size);
+    } else {
+        n = file_descriptor_source->block_size - file_descriptor_source->block_offset;
+        if (!n) {
+            n = libis_file_descriptor_source_read_block(file_descriptor_source);
+        }
+        if (0 < n) {
+            if ((size_t) n > size) {
+                n = size;
+            }
+            memcpy(dst, file_descriptor_source->block + file_descriptor_source->block_offset, n);
+            file_descriptor_source->block_offset += n;
+        }
+    }
     if (n < 0) {
         err = LIBIS_ERROR_IO;
         goto end;
     }
     if (!n) {
         *eof = true;
-        *c = '\0';
+        goto end;
     }
+    *nread = n;
 end:
     return err;
 }
 
+// Read size bytes at offset with pread() retrying on interrupts and short reads.
+static LibisError libis_file_descriptor_source_pread(
+        int file_descriptor, bool *eof, off_t offset, char *dst, size_t size, size_t *nread) {
+    LibisError err = LIBIS_ERROR_OK;
+    ssize_t n;
+    *eof = false;
+    *nread = 0;
+    while (*nread < size) {
+        n = pread(file_descriptor, dst + *nread, size - *nread, offset + *nread);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            err = LIBIS_ERROR_IO;
+            goto end;
+        }
+        if (!n) {
+            *eof = true;
+            goto end;
+        }
+        *nread += n;
+    }
+end:
+    return err;
+}
+
+// see LibSource::read_at
+static LibisError libis_file_descriptor_source_read_at(
+        Libis *libis, LibisSource *source, bool *eof, uint64_t offset, char *dst, size_t size) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisFileDescriptorSource *file_descriptor_source = (LibisFileDescriptorSource *) source;
+    _Alignas(LIBIS_DIRECT_ALIGNMENT) char small[LIBIS_DIRECT_STACK_SIZE];
+    char *block = small;
+    size_t nread;
+    if (!libis || !source || !eof) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (!(file_descriptor_source->flags & LIBIS_FD_DIRECT)) {
+        err = libis_file_descriptor_source_pread(
+                file_descriptor_source->file_descriptor, eof, (off_t) offset, dst, size, &nread);
+        goto end;
+    }
+    // O_DIRECT needs aligned offset, length and memory so read through a bounce block.
+    // Small reads use one on the stack to keep allocator off the random access path.
+    uint64_t aligned_offset = offset - offset % LIBIS_DIRECT_ALIGNMENT;
+    size_t head = offset - aligned_offset;
+    size_t aligned_size = (head + size + LIBIS_DIRECT_ALIGNMENT - 1) / LIBIS_DIRECT_ALIGNMENT * LIBIS_DIRECT_ALIGNMENT;
+    if (sizeof(small) < aligned_size && posix_memalign((void **) &block, LIBIS_DIRECT_ALIGNMENT, aligned_size)) {
+        block = small;
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    err = libis_file_descriptor_source_pread(
+            file_descriptor_source->file_descriptor, eof, (off_t) aligned_offset, block, aligned_size, &nread);
+    if (err) {
+        goto end;
+    }
+    // Short read is expected at the end of file, check that requested bytes are there.
+    *eof = nread < head + size;
+    if (*eof) {
+        goto end;
+    }
+    memcpy(dst, block + head, size);
+end:
+    if (block != small) {
+        free(block);
+    }
+    return err;
+}
+
 // see LibSource::free
-LibisError libis_file_descriptor_source_free(Libis *libis, LibisSource *source) {
+static LibisError libis_file_descriptor_source_free(Libis *libis, LibisSource *source) {
     LibisError err = LIBIS_ERROR_OK;
     if (!libis || !source) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
     LibisFileDescriptorSource *file_descriptor_source = (LibisFileDescriptorSource *) source;
-    if (file_descriptor_source) {
-        close(file_descriptor_source->file_descriptor);
+    if ((file_descriptor_source->flags & LIBIS_FD_DROP_BEHIND)
+            && file_descriptor_source->dropped < file_descriptor_source->offset) {
+        libis_file_descriptor_source_drop_behind(file_descriptor_source, true);
     }
+    close(file_descriptor_source->file_descriptor);
+    free(file_descriptor_source->block);
     free(source);
 end:
     return err;
 }
 
+LibisError libis_source_get_file_descriptor_flags(Libis *libis, LibisSource *source, unsigned *flags) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !source || !flags) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (source->read != libis_file_descriptor_source_read) {
+        err = LIBIS_ERROR_NOT_SUPPORTED;
+        goto end;
+    }
+    *flags = ((LibisFileDescriptorSource *) source)->flags;
+end:
+    return err;
+}
+
 LibisError libis_source_create_from_file_descriptor(Libis *libis, LibisSource **source, int *file_descriptor) {
+    return libis_source_create_from_file_descriptor_with_flags(libis, source, file_descriptor, 0);
+}
+
+LibisError libis_source_create_from_file_descriptor_with_flags(
+        Libis *libis, LibisSource **source, int *file_descriptor, unsigned flags) {
     LibisError err = LIBIS_ERROR_OK;
     LibisFileDescriptorSource *result = NULL;
-    if (!libis || !source) {
+    int status_flags;
+    if (!libis || !source || !file_descriptor) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
@@ -60,13 +257,46 @@ LibisError libis_source_create_from_file_descriptor(Libis *libis, LibisSource **
         goto end;
     }
     result->source.read = libis_file_descriptor_source_read;
+    result->source.read_at = libis_file_descriptor_source_read_at;
     result->source.free = libis_file_descriptor_source_free;
     result->file_descriptor = *file_descriptor;
+    result->flags = flags;
+    result->offset = lseek(*file_descriptor, 0, SEEK_CUR);
+    result->block = NULL;
+    result->block_offset = 0;
+    result->block_size = 0;
+    if (result->offset < 0) {
+        // Pipes and sockets have neither page cache nor O_DIRECT.
+        result->offset = 0;
+        result->flags = 0;
+    }
+    result->dropped = result->offset;
+    if (result->flags & LIBIS_FD_SEQUENTIAL) {
+        posix_fadvise(*file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    if (result->flags & LIBIS_FD_DIRECT) {
+        if (posix_memalign((void **) &result->block, LIBIS_DIRECT_ALIGNMENT, LIBIS_BLOCK_SIZE)) {
+            result->block = NULL;
+            err = LIBIS_ERROR_OUT_OF_MEMORY;
+            goto end;
+        }
+        status_flags = fcntl(*file_descriptor, F_GETFL);
+        if (status_flags < 0 || fcntl(*file_descriptor, F_SETFL, status_flags | O_DIRECT) < 0) {
+            // File system doesn't support O_DIRECT, keep reading through the aligned block anyway.
+            result->flags &= ~LIBIS_FD_DIRECT;
+        }
+    }
     *source = (LibisSource *) result;
     *file_descriptor = -1;
     result = NULL;
 end:
-    close(*file_descriptor);
+    if (file_descriptor && 0 <= *file_descriptor) {
+        close(*file_descriptor);
+        *file_descriptor = -1;
+    }
+    if (result) {
+        free(result->block);
+    }
     free(result);
     return err;
-}
\ No newline at end of file
+}
@@ -1,5 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <libis.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
 
 #include "libis_internal.h"
 
@@ -7,21 +11,34 @@
 typedef struct {
     LibisSource source;
     FILE *file;
+    bool regular; // whether file is a regular file which never blocks reads
 } LibisFileSource;
 
+// fread() waits until it gets all requested bytes which may never come from a pipe, terminal
+// or socket. Only regular files are known to have all bytes up to end of file available.
+static bool libis_file_is_regular(FILE *file) {
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat status;
+    return !fstat(fileno(file), &status) && S_ISREG(status.st_mode);
+#else
+    (void) file;
+    return false;
+#endif
+}
+
 // see LibSource::read
-static LibisError libis_file_source_read(Libis *libis, LibisSource *source, bool *eof, char *c) {
+static LibisError libis_file_source_read(Libis *libis, LibisSource *source, bool *eof,
+        char *dst, size_t min_size, size_t size, size_t *nread) {
     LibisError err = LIBIS_ERROR_OK;
     LibisFileSource *file_source = (LibisFileSource *) source;
-    if (!libis || !source || !c) {
+    if (!libis || !source || !eof || !dst || !min_size || size < min_size || !nread) {
         err = LIBIS_ERROR_BAD_ARGUMENT;
         goto end;
     }
-    size_t nbytes = fread(c, 1, 1, file_source->file);
-    if (nbytes != 1) {
+    *nread = fread(dst, 1, file_source->regular ? size : min_size, file_source->file);
+    if (!*nread) {
         if (feof(file_source->file)) {
             *eof = true;
-            *c = '\0';
         } else {
             err = LIBIS_ERROR_IO;
         }
@@ -61,8 +78,10 @@ LibisError libis_source_create_from_file(Libis *libis, LibisSource **source, FIL
         goto end;
     }
     result->source.read = libis_file_source_read;
+    result->source.read_at = NULL;
     result->source.free = libis_file_source_free;
     result->file = *file;
+    result->regular = libis_file_is_regular(*file);
     *source = (LibisSource *) result;
     *file = NULL;
     result = NULL;
@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "libis_transform_source.h"
+
+// LibisSource which decompresses DEFLATE data of another source
+typedef struct {
+    LibisTransformSource transform_source;
+    z_stream stream;
+    bool initialized; // Whether stream needs inflateEnd()
+    bool member_end; // Whether the last gzip member or zlib/raw stream ended
+    LibisCompressionFormat format;
+} LibisInflateSource;
+
+// see LibisTransformSource::transform
+static LibisError libis_inflate_source_transform(Libis *libis, LibisTransformSource *source,
+        char *dst, size_t size, size_t *nwritten, bool *done) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisInflateSource *inflate_source = (LibisInflateSource *) source;
+    z_stream *stream = &inflate_source->stream;
+    size_t available;
+    int status;
+    if (!libis || !source || !dst || !nwritten || !done) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *nwritten = 0;
+    *done = false;
+    available = source->input_size - source->input_offset;
+    if (inflate_source->member_end) {
+        // Concatenated gzip members decompress into a single stream.
+        if (inflate_source->format != LIBIS_FORMAT_GZIP || (!available && source->inner_eof)) {
+            *done = true;
+            goto end;
+        }
+        if (!available) {
+            goto end;
+        }
+        if (inflateReset(stream) != Z_OK) {
+            err = LIBIS_ERROR_MALFORMED;
+            goto end;
+        }
+        inflate_source->member_end = false;
+    }
+    stream->next_in = (Bytef *) source->input + source->input_offset;
+    stream->avail_in = (uInt) available;
+    stream->next_out = (Bytef *) dst;
+    stream->avail_out = size < UINT_MAX ? (uInt) size : UINT_MAX;
+    status = inflate(stream, Z_NO_FLUSH);
+    source->input_offset += available - stream->avail_in;
+    *nwritten = (size_t) ((char *) stream->next_out - dst);
+    switch (status) {
+    case Z_OK:
+    case Z_BUF_ERROR: // no progress possible without more input
+        break;
+    case Z_STREAM_END:
+        inflate_source->member_end = true;
+        break;
+    case Z_MEM_ERROR:
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        break;
+    default:
+        err = LIBIS_ERROR_MALFORMED;
+        break;
+    }
+end:
+    return err;
+}
+
+// see LibisTransformSource::release
+static void libis_inflate_source_release(Libis *libis, LibisTransformSource *source) {
+    LibisInflateSource *inflate_source = (LibisInflateSource *) source;
+    (void) libis;
+    if (inflate_source->initialized) {
+        inflateEnd(&inflate_source->stream);
+        inflate_source->initialized = false;
+    }
+}
+
+LibisError libis_source_create_inflate(
+        Libis *libis, LibisSource **source, LibisSource **inner, LibisCompressionFormat format) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisInflateSource *result = NULL;
+    int window_bits;
+    if (!libis || !source || !inner || !*inner) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    switch (format) {
+    case LIBIS_FORMAT_GZIP:
+        window_bits = 16 + MAX_WBITS;
+        break;
+    case LIBIS_FORMAT_ZLIB:
+        window_bits = MAX_WBITS;
+        break;
+    case LIBIS_FORMAT_RAW:
+        window_bits = -MAX_WBITS;
+        break;
+    default:
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    result = malloc(sizeof(LibisInflateSource));
+    if (!result) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    result->initialized = false;
+    result->member_end = false;
+    result->format = format;
+    err = E(libis_transform_source_init(libis, &result->transform_source, inner));
+    if (err) goto end;
+    result->transform_source.transform = libis_inflate_source_transform;
+    result->transform_source.release = libis_inflate_source_release;
+    result->stream.zalloc = Z_NULL;
+    result->stream.zfree = Z_NULL;
+    result->stream.opaque = Z_NULL;
+    result->stream.next_in = Z_NULL;
+    result->stream.avail_in = 0;
+    if (inflateInit2(&result->stream, window_bits) != Z_OK) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    result->initialized = true;
+    *source = (LibisSource *) result;
+    result = NULL;
+end:
+    if (result && result->transform_source.input) {
+        E(libis_transform_source_free(libis, (LibisSource *) result));
+    } else {
+        free(result);
+    }
+    // Without libis inner source can't be freed, it stays with the caller.
+    if (libis && inner) {
+        E(libis_source_destroy(libis, inner));
+    }
+    return err;
+}
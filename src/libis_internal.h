@@ -1,11 +1,102 @@
 #ifndef LIBIS_INTERNAL_H
 #define LIBIS_INTERNAL_H
 
+#include <limits.h>
 #include <libis.h>
 #include "libis_source.h"
 
 #define E libis_handle_internal_error
 
+// Number of bytes the input stream requests from its source at once.
+#define LIBIS_BLOCK_SIZE 65536
+
+// State of checksum computed over consumed bytes
+typedef struct {
+    LibisChecksumKind kind;
+    uint32_t crc; // Running CRC-32 or CRC-32C
+    uint64_t accumulators[4]; // XXH64 lanes
+    uint64_t total; // Number of bytes hashed by XXH64
+    char stripe[32]; // Bytes not yet hashed by XXH64
+    size_t stripe_size; // Number of bytes in stripe
+} LibisChecksumState;
+
+struct Libis_ {
+    uint32_t crc32_table[8][256]; // Slicing-by-8 tables for CRC-32
+    uint32_t crc32c_table[8][256]; // Slicing-by-8 tables for CRC-32C
+    bool crc32c_hardware; // Whether CPU has SSE4.2 crc32 instruction
+};
+
+// Bytes get read lazily from source into the buffer block by block.
+// When the user needs to look ahead by n bytes and fewer than n unread
+// bytes are buffered, unread bytes get moved to the start of the buffer
+// and the rest of the buffer gets refilled from source. libis_read_* calls
+// consume bytes from the buffer by moving buffer_offset forward.
+struct LibisInputStream_ {
+    LibisSource *source;
+    char *buffer;
+    size_t buffer_offset; // Index of the next unread byte in buffer
+    size_t buffer_size; // Number of bytes filled into buffer
+    size_t buffer_capacity; // Buffer length
+    size_t lookahead; // How far the user is allowed to look ahead
+    unsigned bit_offset; // Bit offset from start of unread bytes (always less than CHAR_BIT)
+    // Consumed bytes are observed (hashed) lazily in bulk right before they leave the buffer
+    // so that per byte readers don't pay for it.
+    size_t observed; // Index in buffer up to which consumed bytes are observed
+    bool checksum_enabled;
+    LibisChecksumState checksum;
+    uint64_t discarded; // Number of consumed bytes dropped from buffer
+    bool position_enabled;
+    uint64_t line; // Line of the first unobserved byte counting from 1
+    uint64_t column; // Column of the first unobserved byte counting from 1
+};
+
 LibisError libis_handle_internal_error(LibisError err);
 
+// Pass bytes consumed since the last call to checksum and position tracker.
+void libis_observe_consumed(Libis *libis, LibisInputStream *input);
+
+// Advance line and column past size bytes at p.
+void libis_position_update(LibisInputStream *input, const char *p, size_t size);
+
+// Fill tables used for computing checksums.
+void libis_checksum_init(Libis *libis);
+
+// Add size bytes at p to checksum.
+void libis_checksum_update(Libis *libis, LibisChecksumState *state, const char *p, size_t size);
+
+// Make at least size unread bytes available in buffer reading them from source.
+// Unlike libis_lookahead() it is limited by buffer capacity rather than lookahead.
+LibisError libis_fill(Libis *libis, LibisInputStream *input, bool *eof, size_t size);
+
+// Consume next size bytes of input stream.
+LibisError libis_skip_bytes(Libis *libis, LibisInputStream *input, bool *eof, size_t size);
+
+// Decode integers stored at p in little or big endian.
+
+static inline uint16_t libis_load_u16_le(const char *p) {
+    const unsigned char *b = (const unsigned char *) p;
+    return (uint16_t) ((uint16_t) b[1] << CHAR_BIT | (uint16_t) b[0]);
+}
+
+static inline uint16_t libis_load_u16_be(const char *p) {
+    const unsigned char *b = (const unsigned char *) p;
+    return (uint16_t) ((uint16_t) b[0] << CHAR_BIT | (uint16_t) b[1]);
+}
+
+static inline uint32_t libis_load_u32_le(const char *p) {
+    return (uint32_t) libis_load_u16_le(p + 2) << 16 | libis_load_u16_le(p);
+}
+
+static inline uint32_t libis_load_u32_be(const char *p) {
+    return (uint32_t) libis_load_u16_be(p) << 16 | libis_load_u16_be(p + 2);
+}
+
+static inline uint64_t libis_load_u64_le(const char *p) {
+    return (uint64_t) libis_load_u32_le(p + 4) << 32 | libis_load_u32_le(p);
+}
+
+static inline uint64_t libis_load_u64_be(const char *p) {
+    return (uint64_t) libis_load_u32_be(p) << 32 | libis_load_u32_be(p + 4);
+}
+
 #endif
@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <locale.h>
+
+#include "libis_internal.h"
+
+// Numbers get parsed in place from unread bytes of the buffer. Parsers address bytes by index
+// relative to the first unread byte so that refilling the buffer in the middle of a number
+// which straddles two blocks doesn't invalidate anything. Bytes get consumed only after
+// the whole number is parsed successfully.
+
+// Get byte at index of unread bytes into *c or -1 if input ends before it.
+static inline LibisError libis_number_peek(Libis *libis, LibisInputStream *input, size_t index, int *c) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool eof;
+    if (input->buffer_size - input->buffer_offset <= index) {
+        err = E(libis_fill(libis, input, &eof, index + 1));
+        if (eof || err) {
+            *c = -1;
+            goto end;
+        }
+    }
+    *c = (unsigned char) input->buffer[input->buffer_offset + index];
+end:
+    return err;
+}
+
+// Check whether all 8 bytes of little endian word are ASCII decimal digits.
+static inline bool libis_is_eight_digits(uint64_t word) {
+    return ((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+            == 0x3333333333333333;
+}
+
+// Convert 8 ASCII decimal digits of little endian word into number with 3 multiplications.
+static inline uint64_t libis_parse_eight_digits(uint64_t word) {
+    word -= 0x3030303030303030;
+    word = word * 10 + (word >> 8);
+    return ((word & 0x000000FF000000FF) * 0x000F424000000064
+            + ((word >> 16) & 0x000000FF000000FF) * 0x0000271000000001) >> 32;
+}
+
+static inline int libis_digit_value(int c, unsigned base) {
+    if ('0' <= c && c <= '9') {
+        return c - '0';
+    }
+    if (base == 16 && 'a' <= c && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (base == 16 && 'A' <= c && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Accumulate digits in base 10 or 16 starting at *index of unread bytes into *value.
+// Advances *index past the digits, adds their count to *ndigits and sets *overflow if
+// *value doesn't fit into uint64_t. Decimal digits are classified and converted 8 at a time.
+static LibisError libis_scan_digits(Libis *libis, LibisInputStream *input, unsigned base,
+        size_t *index, uint64_t *value, size_t *ndigits, bool *overflow) {
+    LibisError err = LIBIS_ERROR_OK;
+    uint64_t word;
+    int c, digit;
+    for (;;) {
+        const char *p = input->buffer + input->buffer_offset + *index;
+        size_t available = input->buffer_size - input->buffer_offset - *index;
+        while (base == 10 && 8 <= available && libis_is_eight_digits(word = libis_load_u64_le(p))) {
+            word = libis_parse_eight_digits(word);
+            if ((UINT64_MAX - word) / 100000000 < *value) {
+                *overflow = true;
+            }
+            *value = *value * 100000000 + word;
+            p += 8;
+            available -= 8;
+            *index += 8;
+            *ndigits += 8;
+        }
+        while (available && 0 <= (digit = libis_digit_value((unsigned char) *p, base))) {
+            if ((UINT64_MAX - digit) / base < *value) {
+                *overflow = true;
+            }
+            *value = *value * base + digit;
+            ++p;
+            --available;
+            ++*index;
+            ++*ndigits;
+        }
+        if (available) {
+            goto end;
+        }
+        // Digits run up to the end of buffered bytes, the number may continue in the next block.
+        err = E(libis_number_peek(libis, input, *index, &c));
+        if (err || c < 0) {
+            goto end;
+        }
+    }
+end:
+    return err;
+}
+
+// Parse integer [+-]?[digits]+ in base 10 or 16 at the start of unread bytes without consuming it.
+// *length sets to the length of number in bytes or to 0 if there is no number.
+static LibisError libis_parse_integer(Libis *libis, LibisInputStream *input, bool *eof, unsigned base,
+        bool *negative, uint64_t *magnitude, bool *overflow, size_t *length) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t index = 0, ndigits = 0;
+    int c;
+    *negative = false;
+    *magnitude = 0;
+    *overflow = false;
+    *length = 0;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    err = E(libis_fill(libis, input, eof, 1));
+    if (*eof || err) {
+        goto end;
+    }
+    c = (unsigned char) input->buffer[input->buffer_offset];
+    if (c == '+' || c == '-') {
+        *negative = c == '-';
+        ++index;
+    }
+    err = E(libis_scan_digits(libis, input, base, &index, magnitude, &ndigits, overflow));
+    if (err) goto end;
+    if (ndigits) {
+        *length = index;
+    }
+end:
+    return err;
+}
+
+// Read integer in base 10 or 16 which fits into [-max_negative, max_positive].
+static LibisError libis_read_integer(Libis *libis, LibisInputStream *input, bool *eof, unsigned base,
+        uint64_t max_negative, uint64_t max_positive, bool *negative, uint64_t *magnitude) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool overflow;
+    size_t length;
+    if (!libis || !input || !eof) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    err = E(libis_parse_integer(libis, input, eof, base, negative, magnitude, &overflow, &length));
+    if (*eof || err) {
+        goto end;
+    }
+    if (!length) {
+        err = LIBIS_ERROR_MALFORMED;
+        goto end;
+    }
+    if (overflow || (*negative ? max_negative : max_positive) < *magnitude) {
+        err = LIBIS_ERROR_OUT_OF_RANGE;
+        goto end;
+    }
+    input->buffer_offset += length;
+end:
+    return err;
+}
+
+LibisError libis_read_int64(Libis *libis, LibisInputStream *input, bool *eof, int64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool negative;
+    uint64_t magnitude;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_integer(libis, input, eof, 10,
+            (uint64_t) INT64_MAX + 1, INT64_MAX, &negative, &magnitude));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+end:
+    return err;
+}
+
+LibisError libis_read_uint64(Libis *libis, LibisInputStream *input, bool *eof, uint64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool negative;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_integer(libis, input, eof, 10, 0, UINT64_MAX, &negative, out));
+    if (err) {
+        *out = 0;
+    }
+end:
+    return err;
+}
+
+LibisError libis_read_int64_hex(Libis *libis, LibisInputStream *input, bool *eof, int64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool negative;
+    uint64_t magnitude;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_integer(libis, input, eof, 16,
+            (uint64_t) INT64_MAX + 1, INT64_MAX, &negative, &magnitude));
+    if (*eof || err) {
+        goto end;
+    }
+    *out = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+end:
+    return err;
+}
+
+LibisError libis_read_uint64_hex(Libis *libis, LibisInputStream *input, bool *eof, uint64_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool negative;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    err = E(libis_read_integer(libis, input, eof, 16, 0, UINT64_MAX, &negative, out));
+    if (err) {
+        *out = 0;
+    }
+end:
+    return err;
+}
+
+// Convert text of a number in unread bytes with strtod(). Slow path for numbers which
+// can't be converted exactly with a single floating point operation. strtod() expects
+// the radix character of LC_NUMERIC so '.' gets replaced with it in a copy of the text.
+static LibisError libis_strtod(LibisInputStream *input, size_t length, double *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    const char *number = input->buffer + input->buffer_offset;
+    const char *dot = memchr(number, '.', length);
+    const char *decimal_point = localeconv()->decimal_point;
+    size_t decimal_point_size = strlen(decimal_point);
+    size_t size = length, head;
+    char small[64];
+    char *text = small;
+    if (dot) {
+        size = length - 1 + decimal_point_size;
+    }
+    if (sizeof(small) <= size) {
+        text = malloc(size + 1);
+        if (!text) {
+            err = LIBIS_ERROR_OUT_OF_MEMORY;
+            goto end;
+        }
+    }
+    if (dot) {
+        head = dot - number;
+        memcpy(text, number, head);
+        memcpy(text + head, decimal_point, decimal_point_size);
+        memcpy(text + head + decimal_point_size, dot + 1, length - head - 1);
+    } else {
+        memcpy(text, number, length);
+    }
+    text[size] = '\0';
+    *out = strtod(text, NULL);
+end:
+    if (text != small) {
+        free(text);
+    }
+    return err;
+}
+
+// Powers of ten which are exactly representable as double.
+static const double libis_exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+LibisError libis_read_double(Libis *libis, LibisInputStream *input, bool *eof, double *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    bool negative, overflow, exponent_negative = false, exponent_overflow = false;
+    uint64_t mantissa, exponent_magnitude = 0;
+    size_t length, ndigits = 0, nfraction = 0, nexponent = 0, index;
+    int64_t exponent;
+    int c;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *out = 0;
+    // Integer part
+    err = E(libis_parse_integer(libis, input, eof, 10, &negative, &mantissa, &overflow, &length));
+    if (*eof || err) {
+        goto end;
+    }
+    index = length;
+    ndigits = length;
+    if (!length) {
+        c = (unsigned char) input->buffer[input->buffer_offset];
+        index = c == '+' || c == '-';
+        ndigits = 0;
+    }
+    // Fraction part
+    err = E(libis_number_peek(libis, input, index, &c));
+    if (err) goto end;
+    if (c == '.') {
+        ++index;
+        err = E(libis_scan_digits(libis, input, 10, &index, &mantissa, &nfraction, &overflow));
+        if (err) goto end;
+    }
+    if (!ndigits && !nfraction) {
+        err = LIBIS_ERROR_MALFORMED;
+        goto end;
+    }
+    length = index;
+    // Exponent part is a part of the number only if it has digits
+    err = E(libis_number_peek(libis, input, index, &c));
+    if (err) goto end;
+    if (c == 'e' || c == 'E') {
+        ++index;
+        err = E(libis_number_peek(libis, input, index, &c));
+        if (err) goto end;
+        if (c == '+' || c == '-') {
+            exponent_negative = c == '-';
+            ++index;
+        }
+        err = E(libis_scan_digits(libis, input, 10, &index, &exponent_magnitude, &nexponent, &exponent_overflow));
+        if (err) goto end;
+        if (nexponent) {
+            length = index;
+        }
+    }
+    // Clinger's fast path: both mantissa and power of ten are exact doubles so is their quotient or product.
+#if FLT_EVAL_METHOD == 0
+    exponent = exponent_magnitude <= INT32_MAX ? (int64_t) exponent_magnitude : INT32_MAX;
+    exponent = (exponent_negative ? -exponent : exponent) - (int64_t) nfraction;
+    if (!overflow && !exponent_overflow && mantissa <= (uint64_t) 1 << DBL_MANT_DIG
+            && -22 <= exponent && exponent <= 22) {
+        *out = (double) mantissa;
+        *out = exponent < 0 ? *out / libis_exact_powers_of_ten[-exponent]
+                : *out * libis_exact_powers_of_ten[exponent];
+        *out = negative ? -*out : *out;
+        input->buffer_offset += length;
+        goto end;
+    }
+#endif
+    err = E(libis_strtod(input, length, out));
+    if (err) goto end;
+    input->buffer_offset += length;
+end:
+    return err;
+}
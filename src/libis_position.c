@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "libis_internal.h"
+
+// Count '\n' bytes in little endian word: a byte of word ^ "\n\n\n\n\n\n\n\n" is zero exactly
+// where word has '\n'. Zero bytes get their high bit set without carries between bytes.
+static inline unsigned libis_count_newlines_in_word(uint64_t word) {
+    uint64_t x = word ^ 0x0A0A0A0A0A0A0A0A;
+    uint64_t zeros = ~(((x & 0x7F7F7F7F7F7F7F7F) + 0x7F7F7F7F7F7F7F7F) | x) & 0x8080808080808080;
+    return (unsigned) ((zeros >> 7) * 0x0101010101010101 >> 56);
+}
+
+void libis_position_update(LibisInputStream *input, const char *p, size_t size) {
+    uint64_t newlines = 0, word;
+    size_t i = 0, last;
+    for (; 8 <= size - i; i += 8) {
+        memcpy(&word, p + i, sizeof(word));
+        newlines += libis_count_newlines_in_word(word);
+    }
+    for (; i < size; ++i) {
+        newlines += p[i] == '\n';
+    }
+    if (!newlines) {
+        input->column += size;
+        return;
+    }
+    last = size;
+    while (p[--last] != '\n') {
+    }
+    input->line += newlines;
+    input->column = size - last;
+}
+
+LibisError libis_enable_position_tracking(Libis *libis, LibisInputStream *input) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    libis_observe_consumed(libis, input);
+    input->position_enabled = true;
+    input->line = 1;
+    input->column = 1;
+end:
+    return err;
+}
+
+LibisError libis_get_position(
+        Libis *libis, LibisInputStream *input, uint64_t *offset, uint64_t *line, uint64_t *column) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !input) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    libis_observe_consumed(libis, input);
+    if (offset) {
+        *offset = input->discarded + input->buffer_offset;
+    }
+    if (line) {
+        *line = input->position_enabled ? input->line : 0;
+    }
+    if (column) {
+        *column = input->position_enabled ? input->column : 0;
+    }
+end:
+    return err;
+}
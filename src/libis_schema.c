@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "libis_internal.h"
+
+// Step of a compiled schema. Copies bytes of the record from input stream into memory
+// decoding integers of foreign byte order into native one.
+typedef enum {
+    LIBIS_SCHEMA_COPY, // copy size bytes as is
+    LIBIS_SCHEMA_U16_LE,
+    LIBIS_SCHEMA_U16_BE,
+    LIBIS_SCHEMA_U32_LE,
+    LIBIS_SCHEMA_U32_BE,
+    LIBIS_SCHEMA_U64_LE,
+    LIBIS_SCHEMA_U64_BE,
+} LibisSchemaOpKind;
+
+typedef struct {
+    LibisSchemaOpKind kind;
+    size_t input_offset; // Offset of the field in input stream record
+    size_t record_offset; // Offset of the field in memory record
+    size_t size; // Number of bytes to copy
+} LibisSchemaOp;
+
+struct LibisSchema_ {
+    size_t input_size; // Size of record in input stream
+    size_t record_size; // Size of record in memory
+    size_t ops_size; // Number of ops
+    size_t ops_capacity; // Length of ops
+    LibisSchemaOp *ops;
+};
+
+static bool libis_is_host_little_endian(void) {
+    const uint16_t one = 1;
+    return *(const unsigned char *) &one == 1;
+}
+
+// Append op to schema merging it into the previous copy when both are contiguous.
+static LibisError libis_schema_append(LibisSchema *schema, LibisSchemaOpKind kind, size_t size, size_t alignment) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisSchemaOp *ops;
+    LibisSchemaOp *last = schema->ops_size ? &schema->ops[schema->ops_size - 1] : NULL;
+    size_t record_offset = (schema->record_size + alignment - 1) / alignment * alignment;
+    if (kind == LIBIS_SCHEMA_COPY && last && last->kind == LIBIS_SCHEMA_COPY
+            && last->record_offset + last->size == record_offset
+            && last->input_offset + last->size == schema->input_size) {
+        last->size += size;
+        goto end;
+    }
+    if (schema->ops_size == schema->ops_capacity) {
+        ops = realloc(schema->ops, 2 * schema->ops_capacity * sizeof(LibisSchemaOp));
+        if (!ops) {
+            err = LIBIS_ERROR_OUT_OF_MEMORY;
+            goto end;
+        }
+        schema->ops = ops;
+        schema->ops_capacity *= 2;
+    }
+    schema->ops[schema->ops_size].kind = kind;
+    schema->ops[schema->ops_size].input_offset = schema->input_size;
+    schema->ops[schema->ops_size].record_offset = record_offset;
+    schema->ops[schema->ops_size].size = size;
+    ++schema->ops_size;
+end:
+    if (!err) {
+        schema->input_size += size;
+        schema->record_size = record_offset + size;
+    }
+    return err;
+}
+
+// Parse field type at *description into size of the field and op which reads it.
+static LibisError libis_schema_parse_field(
+        const char **description, bool little_endian, LibisSchemaOpKind *kind, size_t *size, size_t *alignment) {
+    LibisError err = LIBIS_ERROR_OK;
+    const char *p = *description;
+    char *number_end;
+    unsigned long bits;
+    if (!strncmp(p, "bytes[", 6)) {
+        p += 6;
+        if (!isdigit((unsigned char) *p)) {
+            err = LIBIS_ERROR_BAD_ARGUMENT;
+            goto end;
+        }
+        *size = strtoul(p, &number_end, 10);
+        if (*number_end != ']' || !*size || LIBIS_BLOCK_SIZE < *size) {
+            err = LIBIS_ERROR_BAD_ARGUMENT;
+            goto end;
+        }
+        p = number_end + 1;
+        *kind = LIBIS_SCHEMA_COPY;
+        *alignment = 1;
+        goto end;
+    }
+    if ((*p != 'u' && *p != 'i' && *p != 'f') || !isdigit((unsigned char) p[1])) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    bits = strtoul(p + 1, &number_end, 10);
+    if (bits != 8 && bits != 16 && bits != 32 && bits != 64) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (*p == 'f' && bits != 32 && bits != 64) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    p = number_end;
+    *size = bits / CHAR_BIT;
+    *alignment = *size;
+    if (*size == 1 || little_endian == libis_is_host_little_endian()) {
+        *kind = LIBIS_SCHEMA_COPY;
+    } else if (*size == 2) {
+        *kind = little_endian ? LIBIS_SCHEMA_U16_LE : LIBIS_SCHEMA_U16_BE;
+    } else if (*size == 4) {
+        *kind = little_endian ? LIBIS_SCHEMA_U32_LE : LIBIS_SCHEMA_U32_BE;
+    } else {
+        *kind = little_endian ? LIBIS_SCHEMA_U64_LE : LIBIS_SCHEMA_U64_BE;
+    }
+end:
+    if (!err && *p && !isspace((unsigned char) *p) && *p != '<' && *p != '>') {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+    }
+    *description = p;
+    return err;
+}
+
+LibisError libis_schema_compile(Libis *libis, LibisSchema **schema, const char *description) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisSchema *result = NULL;
+    bool little_endian = true;
+    LibisSchemaOpKind kind;
+    size_t size, alignment, max_alignment = 1;
+    if (!libis || !schema || !description) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    result = malloc(sizeof(LibisSchema));
+    if (!result) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    result->input_size = 0;
+    result->record_size = 0;
+    result->ops_size = 0;
+    result->ops_capacity = 8;
+    result->ops = malloc(result->ops_capacity * sizeof(LibisSchemaOp));
+    if (!result->ops) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    while (*description) {
+        if (isspace((unsigned char) *description)) {
+            ++description;
+        } else if (*description == '<' || *description == '>') {
+            little_endian = *description == '<';
+            ++description;
+        } else {
+            err = libis_schema_parse_field(&description, little_endian, &kind, &size, &alignment);
+            if (err) goto end;
+            // Whole record must fit into the stream buffer.
+            if (LIBIS_BLOCK_SIZE - result->input_size < size) {
+                err = LIBIS_ERROR_BAD_ARGUMENT;
+                goto end;
+            }
+            err = E(libis_schema_append(result, kind, size, alignment));
+            if (err) goto end;
+            if (max_alignment < alignment) {
+                max_alignment = alignment;
+            }
+        }
+    }
+    if (!result->input_size) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    result->record_size = (result->record_size + max_alignment - 1) / max_alignment * max_alignment;
+    *schema = result;
+    result = NULL;
+end:
+    if (result) {
+        free(result->ops);
+        free(result);
+    }
+    return err;
+}
+
+LibisError libis_schema_destroy(Libis *libis, LibisSchema **schema) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !schema) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (*schema) {
+        free((*schema)->ops);
+        free(*schema);
+        *schema = NULL;
+    }
+end:
+    return err;
+}
+
+LibisError libis_schema_get_size(Libis *libis, const LibisSchema *schema, size_t *input_size, size_t *record_size) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !schema) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (input_size) {
+        *input_size = schema->input_size;
+    }
+    if (record_size) {
+        *record_size = schema->record_size;
+    }
+end:
+    return err;
+}
+
+// Decode one record from src into dst following ops of schema.
+static void libis_schema_execute(const LibisSchema *schema, const char *src, char *dst) {
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+    for (const LibisSchemaOp *op = schema->ops; op != schema->ops + schema->ops_size; ++op) {
+        const char *from = src + op->input_offset;
+        char *to = dst + op->record_offset;
+        switch (op->kind) {
+        case LIBIS_SCHEMA_COPY:
+            memcpy(to, from, op->size);
+            break;
+        case LIBIS_SCHEMA_U16_LE:
+            u16 = libis_load_u16_le(from);
+            memcpy(to, &u16, sizeof(u16));
+            break;
+        case LIBIS_SCHEMA_U16_BE:
+            u16 = libis_load_u16_be(from);
+            memcpy(to, &u16, sizeof(u16));
+            break;
+        case LIBIS_SCHEMA_U32_LE:
+            u32 = libis_load_u32_le(from);
+            memcpy(to, &u32, sizeof(u32));
+            break;
+        case LIBIS_SCHEMA_U32_BE:
+            u32 = libis_load_u32_be(from);
+            memcpy(to, &u32, sizeof(u32));
+            break;
+        case LIBIS_SCHEMA_U64_LE:
+            u64 = libis_load_u64_le(from);
+            memcpy(to, &u64, sizeof(u64));
+            break;
+        case LIBIS_SCHEMA_U64_BE:
+            u64 = libis_load_u64_be(from);
+            memcpy(to, &u64, sizeof(u64));
+            break;
+        }
+    }
+}
+
+LibisError libis_read_record(
+        Libis *libis, LibisInputStream *input, bool *eof, const LibisSchema *schema, void *dst) {
+    size_t nread;
+    return libis_read_records(libis, input, eof, schema, dst, 1, schema ? schema->record_size : 0, &nread);
+}
+
+LibisError libis_read_records(Libis *libis, LibisInputStream *input, bool *eof,
+        const LibisSchema *schema, void *dst, size_t count, size_t stride, size_t *nread) {
+    LibisError err = LIBIS_ERROR_OK;
+    char *record = dst;
+    size_t n;
+    if (!libis || !input || !eof || !schema || (!dst && count) || stride < schema->record_size || !nread) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *nread = 0;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    while (count) {
+        err = E(libis_fill(libis, input, eof, schema->input_size));
+        if (*eof || err) {
+            goto end;
+        }
+        n = (input->buffer_size - input->buffer_offset) / schema->input_size;
+        if (count < n) {
+            n = count;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            libis_schema_execute(schema, input->buffer + input->buffer_offset, record);
+            input->buffer_offset += schema->input_size;
+            record += stride;
+        }
+        count -= n;
+        *nread += n;
+    }
+end:
+    return err;
+}
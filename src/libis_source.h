@@ -5,10 +5,19 @@
 #include <stdbool.h>
 
 struct LibisSource_ {
-    // Read single byte from source into *c.
-    // If end of file is reached *eof sets to true and *c sets to '\0'.
-    // Otherwise *eof sets to false and *c sets to the next byte in the source.
-    LibisError (*read)(Libis *libis, LibisSource *source, bool *eof, char *c);
+    // Read at most size bytes from source into dst. *nread sets to the number of bytes read.
+    // Sources return the bytes which are readily available rather than wait to fill whole dst.
+    // min_size (from 1 to size) is the number of bytes the caller needs. Sources which can't tell
+    // how many bytes are available without blocking must not wait for more than min_size bytes.
+    // If end of file is reached *eof sets to true and *nread sets to 0.
+    // Otherwise *eof sets to false and *nread is at least 1.
+    LibisError (*read)(Libis *libis, LibisSource *source, bool *eof,
+            char *dst, size_t min_size, size_t size, size_t *nread);
+
+    // Read size bytes at offset from source into dst without changing state of the source.
+    // Must be safe to call from many threads at once. *eof sets to true if source ends before
+    // size bytes are read. May be NULL if the source doesn't support positional reads.
+    LibisError (*read_at)(Libis *libis, LibisSource *source, bool *eof, uint64_t offset, char *dst, size_t size);
 
     // Free resources taken by a source.
     LibisError (*free)(Libis *libis, LibisSource *source);
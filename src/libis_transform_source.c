@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "libis_transform_source.h"
+
+LibisError libis_transform_source_init(Libis *libis, LibisTransformSource *source, LibisSource **inner) {
+    LibisError err = LIBIS_ERROR_OK;
+    if (!libis || !source || !inner || !*inner) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    source->source.read = libis_transform_source_read;
+    source->source.read_at = NULL;
+    source->source.free = libis_transform_source_free;
+    source->inner = NULL;
+    source->input_offset = 0;
+    source->input_size = 0;
+    source->inner_eof = false;
+    source->transform = NULL;
+    source->release = NULL;
+    source->input = malloc(LIBIS_BLOCK_SIZE);
+    if (!source->input) {
+        err = LIBIS_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
+    source->inner = *inner;
+    *inner = NULL;
+end:
+    return err;
+}
+
+// Move untransformed bytes to the start of input and append next block of inner source.
+static LibisError libis_transform_source_refill(Libis *libis, LibisTransformSource *source) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t nread;
+    memmove(source->input, source->input + source->input_offset, source->input_size - source->input_offset);
+    source->input_size -= source->input_offset;
+    source->input_offset = 0;
+    if (source->input_size == LIBIS_BLOCK_SIZE) {
+        // Transform can't make progress even with a whole block of input.
+        err = LIBIS_ERROR_MALFORMED;
+        goto end;
+    }
+    // Any amount of input lets transform make progress so don't wait for a whole block.
+    err = E(source->inner->read(libis, source->inner, &source->inner_eof,
+            source->input + source->input_size, 1, LIBIS_BLOCK_SIZE - source->input_size, &nread));
+    if (err) goto end;
+    source->input_size += nread;
+end:
+    return err;
+}
+
+LibisError libis_transform_source_read(
+        Libis *libis, LibisSource *source, bool *eof, char *dst, size_t min_size, size_t size, size_t *nread) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisTransformSource *transform_source = (LibisTransformSource *) source;
+    bool need_input, done = false;
+    if (!libis || !source || !eof || !dst || !min_size || size < min_size || !nread) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *nread = 0;
+    need_input = transform_source->input_offset == transform_source->input_size;
+    for (;;) {
+        if (need_input && !transform_source->inner_eof) {
+            err = E(libis_transform_source_refill(libis, transform_source));
+            if (err) goto end;
+        }
+        err = E(transform_source->transform(libis, transform_source, dst, size, nread, &done));
+        if (err || *nread) {
+            goto end;
+        }
+        if (done) {
+            *eof = true;
+            goto end;
+        }
+        if (transform_source->inner_eof) {
+            // Inner source ended in the middle of transformed stream.
+            err = LIBIS_ERROR_MALFORMED;
+            goto end;
+        }
+        need_input = true;
+    }
+end:
+    return err;
+}
+
+LibisError libis_transform_source_free(Libis *libis, LibisSource *source) {
+    LibisError err = LIBIS_ERROR_OK;
+    LibisTransformSource *transform_source = (LibisTransformSource *) source;
+    if (!libis || !source) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    if (transform_source->release) {
+        transform_source->release(libis, transform_source);
+    }
+    E(libis_source_destroy(libis, &transform_source->inner));
+    free(transform_source->input);
+    free(source);
+end:
+    return err;
+}
@@ -0,0 +1,42 @@
+#ifndef LIBIS_TRANSFORM_SOURCE_H
+#define LIBIS_TRANSFORM_SOURCE_H
+
+#include "libis_internal.h"
+
+// LibisSource which reads bytes of another (inner) source and transforms them on the fly:
+// decompresses, decodes, decrypts... Concrete transforms embed LibisTransformSource as
+// their first member, call libis_transform_source_init() and implement transform and release.
+// Transforms write straight into the block requested by the reader so their output goes
+// through the same bulk refill path as bytes of any other source.
+typedef struct LibisTransformSource_ LibisTransformSource;
+
+struct LibisTransformSource_ {
+    LibisSource source;
+    LibisSource *inner;
+    char *input; // Bytes read from inner source
+    size_t input_offset; // Index of the next byte in input to transform
+    size_t input_size; // Number of bytes filled into input
+    bool inner_eof; // Whether inner source is exhausted
+
+    // Transform bytes of input starting from input_offset into at most size bytes at dst.
+    // Advances input_offset past consumed bytes. *nwritten sets to the number of bytes written.
+    // *done sets to true when transformed stream ends.
+    LibisError (*transform)(Libis *libis, LibisTransformSource *source,
+            char *dst, size_t size, size_t *nwritten, bool *done);
+
+    // Free resources of concrete transform but not the source itself.
+    void (*release)(Libis *libis, LibisTransformSource *source);
+};
+
+// Initialize common part of transform source taking ownership of *inner.
+// transform and release must be set by the caller.
+LibisError libis_transform_source_init(Libis *libis, LibisTransformSource *source, LibisSource **inner);
+
+// see LibisSource::read
+LibisError libis_transform_source_read(
+        Libis *libis, LibisSource *source, bool *eof, char *dst, size_t min_size, size_t size, size_t *nread);
+
+// see LibisSource::free
+LibisError libis_transform_source_free(Libis *libis, LibisSource *source);
+
+#endif
@@ -0,0 +1,243 @@
+#include <string.h>
+
+#include "libis_internal.h"
+
+// Longest UTF-8 sequence
+#define LIBIS_UTF8_MAX 4
+
+typedef enum {
+    LIBIS_UTF8_VALID,
+    LIBIS_UTF8_INVALID,
+    LIBIS_UTF8_INCOMPLETE, // valid so far but truncated
+} LibisUtf8Status;
+
+// Decode one code point from n bytes at p following table 3-7 of the Unicode standard
+// which rules out overlong forms, surrogates and code points beyond U+10FFFF.
+static LibisUtf8Status libis_utf8_decode(const unsigned char *p, size_t n, uint32_t *out, size_t *length) {
+    unsigned char lo = 0x80, hi = 0xBF;
+    uint32_t code_point;
+    if (p[0] < 0x80) {
+        *out = p[0];
+        *length = 1;
+        return LIBIS_UTF8_VALID;
+    }
+    if (0xC2 <= p[0] && p[0] <= 0xDF) {
+        *length = 2;
+        code_point = p[0] & 0x1F;
+    } else if (0xE0 <= p[0] && p[0] <= 0xEF) {
+        *length = 3;
+        code_point = p[0] & 0x0F;
+        lo = p[0] == 0xE0 ? 0xA0 : 0x80;
+        hi = p[0] == 0xED ? 0x9F : 0xBF;
+    } else if (0xF0 <= p[0] && p[0] <= 0xF4) {
+        *length = 4;
+        code_point = p[0] & 0x07;
+        lo = p[0] == 0xF0 ? 0x90 : 0x80;
+        hi = p[0] == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return LIBIS_UTF8_INVALID;
+    }
+    for (size_t i = 1; i < *length; ++i) {
+        if (i == n) {
+            return LIBIS_UTF8_INCOMPLETE;
+        }
+        if (p[i] < lo || hi < p[i]) {
+            return LIBIS_UTF8_INVALID;
+        }
+        code_point = code_point << 6 | (p[i] & 0x3F);
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    *out = code_point;
+    return LIBIS_UTF8_VALID;
+}
+
+// Find length of the longest prefix of n bytes at p made of whole valid code points.
+// *incomplete sets to whether the prefix is followed by a truncated but otherwise valid sequence.
+// Runs of ASCII get checked 8 bytes at a time.
+static size_t libis_utf8_scan(const char *text, size_t n, bool *incomplete) {
+    const unsigned char *p = (const unsigned char *) text;
+    size_t i = 0, length;
+    uint32_t code_point;
+    LibisUtf8Status status;
+    uint64_t word;
+    *incomplete = false;
+    while (i < n) {
+        while (8 <= n - i) {
+            memcpy(&word, p + i, sizeof(word));
+            if (word & 0x8080808080808080) {
+                break;
+            }
+            i += 8;
+        }
+        if (i == n) {
+            break;
+        }
+        status = libis_utf8_decode(p + i, n - i, &code_point, &length);
+        if (status != LIBIS_UTF8_VALID) {
+            *incomplete = status == LIBIS_UTF8_INCOMPLETE;
+            break;
+        }
+        i += length;
+    }
+    return i;
+}
+
+// Get length of sequence which starts with lead byte or 1 if the byte can't start one.
+static size_t libis_utf8_sequence_length(unsigned char lead) {
+    if (0xC2 <= lead && lead <= 0xDF) {
+        return 2;
+    }
+    if (0xE0 <= lead && lead <= 0xEF) {
+        return 3;
+    }
+    if (0xF0 <= lead && lead <= 0xF4) {
+        return 4;
+    }
+    return 1;
+}
+
+// Make sure the next code point is buffered whole if input has it but at most limit bytes of it.
+// Only bytes of the code point are waited for so reading from pipes doesn't block on bytes beyond it.
+// *available sets to number of unread bytes in buffer.
+// *at_end sets to whether the source has no bytes beyond those.
+static LibisError libis_utf8_window(
+        Libis *libis, LibisInputStream *input, size_t limit, size_t *available, bool *at_end) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t length;
+    *at_end = false;
+    if (input->buffer_size == input->buffer_offset) {
+        err = E(libis_fill(libis, input, at_end, 1));
+        if (*at_end || err) {
+            goto end;
+        }
+    }
+    length = libis_utf8_sequence_length((unsigned char) input->buffer[input->buffer_offset]);
+    if (limit < length) {
+        length = limit;
+    }
+    if (input->buffer_size - input->buffer_offset < length) {
+        err = E(libis_fill(libis, input, at_end, length));
+    }
+end:
+    *available = input->buffer_size - input->buffer_offset;
+    return err;
+}
+
+LibisError libis_read_codepoint(Libis *libis, LibisInputStream *input, bool *eof, uint32_t *out) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t available, length;
+    bool at_end;
+    if (!libis || !input || !eof || !out) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *out = 0;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    err = E(libis_utf8_window(libis, input, LIBIS_UTF8_MAX, &available, &at_end));
+    if (err) goto end;
+    if (!available) {
+        *eof = true;
+        goto end;
+    }
+    if (libis_utf8_decode((const unsigned char *) input->buffer + input->buffer_offset,
+            available, out, &length) != LIBIS_UTF8_VALID) {
+        *out = 0;
+        err = LIBIS_ERROR_MALFORMED;
+        goto end;
+    }
+    input->buffer_offset += length;
+end:
+    return err;
+}
+
+LibisError libis_read_utf8_span(
+        Libis *libis, LibisInputStream *input, bool *eof, char *dst, size_t size, size_t *nread) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t available = 0, n = 0, valid;
+    bool at_end, incomplete = false;
+    if (!libis || !input || !eof || (!dst && size) || !nread) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *nread = 0;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    while (*nread < size) {
+        if (*nread && input->buffer_offset == input->buffer_size) {
+            // Don't wait for more input once something is read.
+            break;
+        }
+        err = E(libis_utf8_window(libis, input, size - *nread, &available, &at_end));
+        if (err) goto end;
+        if (!available) {
+            break;
+        }
+        n = size - *nread < available ? size - *nread : available;
+        valid = libis_utf8_scan(input->buffer + input->buffer_offset, n, &incomplete);
+        memcpy(dst + *nread, input->buffer + input->buffer_offset, valid);
+        input->buffer_offset += valid;
+        *nread += valid;
+        if (valid == n) {
+            continue;
+        }
+        // A code point straddling the end of buffered bytes gets completed by the next window
+        // unless it is longer than the rest of dst.
+        if (!incomplete || n != available || at_end || size - *nread <= n - valid) {
+            break;
+        }
+    }
+    if (!*nread && size) {
+        if (!available) {
+            *eof = true;
+        } else if (!incomplete || at_end) {
+            // The next code point is malformed or truncated rather than longer than size.
+            err = LIBIS_ERROR_MALFORMED;
+        }
+    }
+end:
+    return err;
+}
+
+LibisError libis_validate_utf8(Libis *libis, LibisInputStream *input, bool *eof, size_t size, bool *valid) {
+    LibisError err = LIBIS_ERROR_OK;
+    size_t available, n, scanned;
+    bool at_end, incomplete;
+    if (!libis || !input || !eof || !valid) {
+        err = LIBIS_ERROR_BAD_ARGUMENT;
+        goto end;
+    }
+    *eof = false;
+    *valid = true;
+    if (input->bit_offset != 0) {
+        err = LIBIS_ERROR_HANGING_BITS;
+        goto end;
+    }
+    while (size) {
+        err = E(libis_utf8_window(libis, input, size, &available, &at_end));
+        if (err) goto end;
+        if (!available) {
+            *eof = true;
+            goto end;
+        }
+        n = size < available ? size : available;
+        scanned = libis_utf8_scan(input->buffer + input->buffer_offset, n, &incomplete);
+        input->buffer_offset += scanned;
+        size -= scanned;
+        if (scanned == n || (incomplete && n == available && !at_end && n - scanned < size)) {
+            continue;
+        }
+        *valid = false;
+        err = E(libis_skip_bytes(libis, input, eof, size));
+        goto end;
+    }
+end:
+    return err;
+}
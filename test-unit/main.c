@@ -1,7 +1,18 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <libis.h>
+#include <locale.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(LIBIS_WITH_ZLIB)
+#include <zlib.h>
+#endif
 
 static LibisError err;
 
@@ -95,6 +106,933 @@ static void test(LibisSource **source) {
     assert(LIBIS_ERROR_OK == err);
 }
 
+static void test_read_at(LibisSource *source) {
+    bool eof;
+    char bytes[2];
+    uint8_t u8;
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+
+    err = libis_read_u64_be_at(libis, source, &eof, 23, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == 0x7776757473727170);
+
+    err = libis_read_u8_at(libis, source, &eof, 2, &u8);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u8 == 0x10);
+
+    err = libis_read_u16_le_at(libis, source, &eof, 3, &u16);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u16 == 0x2120);
+
+    err = libis_read_u16_be_at(libis, source, &eof, 5, &u16);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u16 == 0x3130);
+
+    err = libis_read_u32_le_at(libis, source, &eof, 7, &u32);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u32 == 0x43424140);
+
+    err = libis_read_u32_be_at(libis, source, &eof, 11, &u32);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u32 == 0x53525150);
+
+    err = libis_read_u64_le_at(libis, source, &eof, 15, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == 0x6766656463626160);
+
+    err = libis_read_at(libis, source, &eof, sizeof(buffer) - 2, bytes, 1);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(bytes[0] == 'X');
+
+    err = libis_read_at(libis, source, &eof, sizeof(buffer) - 2, bytes, 2);
+    assert(eof && LIBIS_ERROR_OK == err);
+
+    err = libis_source_destroy(libis, &source);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+// Pack count values of width bits starting from the least significant bit of each byte.
+static void pack(const uint64_t *values, size_t count, unsigned width, char *out) {
+    memset(out, 0, (count * width + 7) / 8);
+    for (size_t i = 0; i < count; ++i) {
+        for (unsigned j = 0; j < width; ++j) {
+            size_t bit = i * width + j;
+            out[bit / 8] |= (char) ((values[i] >> j & 1) << bit % 8);
+        }
+    }
+}
+
+static void test_bitpacked(void) {
+    // Example from Parquet specification: 0 to 7 bit-packed with width 3 followed by RLE run of 4 fives.
+    static const char hybrid[] = "\x03\x88\xC6\xFA" "\x08\x05";
+    static const uint32_t expected[] = { 0, 1, 2, 3, 4, 5, 6, 7, 5, 5, 5, 5 };
+    // Page of RLE run of ten 5s, two groups of 0 to 15 bit-packed with width 4 and RLE run of two 7s.
+    static const char page[] = "\x14\x05" "\x05\x10\x32\x54\x76\x98\xBA\xDC\xFE" "\x04\x07";
+    static const size_t batches[] = { 4, 6, 3, 1, 9, 2, 1, 4 };
+    enum { COUNT = 21 };
+    LibisSource *source;
+    LibisInputStream *input;
+    LibisRleDecoder *decoder;
+    bool eof;
+    size_t nread, total;
+    uint64_t values[COUNT], u64[COUNT];
+    uint32_t u32[COUNT];
+    char packed[COUNT * 8];
+
+    err = libis_source_create_from_buffer(libis, &source, hybrid, sizeof(hybrid) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_rle_decoder_create(libis, &decoder, 3);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_read_rle_bitpacked_hybrid_u32(libis, input, &eof, decoder, u32, 12, &nread);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(nread == 12);
+    assert(!memcmp(u32, expected, sizeof(expected)));
+    err = libis_read_rle_bitpacked_hybrid_u32(libis, input, &eof, decoder, u32, 1, &nread);
+    assert(eof && LIBIS_ERROR_OK == err);
+    assert(nread == 0);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_rle_decoder_destroy(libis, &decoder);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Runs continue across batches.
+    err = libis_source_create_from_buffer(libis, &source, page, sizeof(page) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_rle_decoder_create(libis, &decoder, 4);
+    assert(LIBIS_ERROR_OK == err);
+    total = 0;
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); ++i) {
+        err = libis_read_rle_bitpacked_hybrid_u32(libis, input, &eof, decoder, u32, batches[i], &nread);
+        assert(LIBIS_ERROR_OK == err);
+        assert(eof == (total + batches[i] > 28));
+        assert(nread == (eof ? 28 - total : batches[i]));
+        for (size_t j = 0; j < nread; ++j, ++total) {
+            assert(u32[j] == (total < 10 ? 5 : total < 26 ? total - 10 : 7));
+        }
+    }
+    assert(total == 28);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_rle_decoder_destroy(libis, &decoder);
+    assert(LIBIS_ERROR_OK == err);
+
+    for (unsigned width = 1; width <= 64; ++width) {
+        for (size_t i = 0; i < COUNT; ++i) {
+            values[i] = (0x9E3779B97F4A7C15u * (i + width)) >> (64 - width);
+        }
+        pack(values, COUNT, width, packed);
+        err = libis_source_create_from_buffer(libis, &source, packed, (COUNT * width + 7) / 8, false);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_create(libis, &input, &source, 1);
+        assert(LIBIS_ERROR_OK == err);
+        if (width <= 32) {
+            err = libis_read_bitpacked_u32(libis, input, &eof, width, u32, COUNT);
+            assert(!eof && LIBIS_ERROR_OK == err);
+            for (size_t i = 0; i < COUNT; ++i) {
+                assert(u32[i] == values[i]);
+            }
+        } else {
+            err = libis_read_bitpacked_u64(libis, input, &eof, width, u64, COUNT);
+            assert(!eof && LIBIS_ERROR_OK == err);
+            assert(!memcmp(u64, values, sizeof(values)));
+        }
+        err = libis_read_bitpacked_u64(libis, input, &eof, width, u64, 1);
+        assert(eof && LIBIS_ERROR_OK == err);
+        err = libis_destroy(libis, &input);
+        assert(LIBIS_ERROR_OK == err);
+    }
+}
+
+static void test_schema(void) {
+    struct {
+        char bits[2];
+        uint8_t u8;
+        uint16_t u16_le;
+        uint16_t u16_be;
+        uint32_t u32_le;
+        uint32_t u32_be;
+        uint64_t u64_le;
+        uint64_t u64_be;
+        char x;
+    } records[3];
+    char twice[2 * (sizeof(buffer) - 1)];
+    LibisSchema *schema;
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof;
+    size_t input_size, record_size, nread;
+
+    err = libis_schema_compile(libis, &schema, "u16 bits");
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    err = libis_schema_compile(NULL, &schema, "u16");
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    // Records must fit into the stream buffer.
+    err = libis_schema_compile(libis, &schema, "bytes[70000]");
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    err = libis_schema_compile(libis, &schema, "bytes[18446744073709551617]");
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    err = libis_schema_compile(libis, &schema, "bytes[65535] u16");
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    err = libis_schema_compile(libis, &schema, "bytes[65534] u16");
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_schema_destroy(libis, &schema);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_schema_compile(libis, &schema, "bytes[2] u8 <u16 >u16 <u32 >u32 <u64 > u64 bytes[1]");
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_schema_get_size(libis, schema, &input_size, &record_size);
+    assert(LIBIS_ERROR_OK == err);
+    assert(input_size == sizeof(buffer) - 1);
+    assert(record_size == sizeof(records[0]));
+
+    memcpy(twice, buffer, sizeof(buffer) - 1);
+    memcpy(twice + sizeof(buffer) - 1, buffer, sizeof(buffer) - 1);
+    err = libis_source_create_from_buffer(libis, &source, twice, sizeof(twice), false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_read_record(libis, input, &eof, schema, &records[0]);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    err = libis_read_records(libis, input, &eof, schema, &records[1], 1, sizeof(records[1]), &nread);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(nread == 1);
+    for (int i = 0; i < 2; ++i) {
+        assert(!memcmp(records[i].bits, "\xDC\xDC", 2));
+        assert(records[i].u8 == 0x10);
+        assert(records[i].u16_le == 0x2120);
+        assert(records[i].u16_be == 0x3130);
+        assert(records[i].u32_le == 0x43424140);
+        assert(records[i].u32_be == 0x53525150);
+        assert(records[i].u64_le == 0x6766656463626160);
+        assert(records[i].u64_be == 0x7776757473727170);
+        assert(records[i].x == 'X');
+    }
+    err = libis_read_record(libis, input, &eof, schema, &records[0]);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Batch running past end of file reports records read before it.
+    err = libis_source_create_from_buffer(libis, &source, twice, sizeof(twice) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    memset(records, 0, sizeof(records));
+    err = libis_read_records(libis, input, &eof, schema, records, 3, sizeof(records[0]), &nread);
+    assert(eof && LIBIS_ERROR_OK == err);
+    assert(nread == 1);
+    assert(records[0].x == 'X' && records[0].u64_be == 0x7776757473727170);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_schema_destroy(libis, &schema);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+// Skip one space after a number.
+static void skip_space(LibisInputStream *input) {
+    bool eof;
+    char c;
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == ' ');
+}
+
+static void test_numbers(void) {
+    static const char text[] =
+            "123 -45 +0 18446744073709551615 18446744073709551616 -9223372036854775808 9223372036854775808 "
+            "ff -7F 3.25 -1e3 .5e-2 7e 12345678901234567890.5 - x";
+    enum { PADDING = 65530 };
+    static char straddling[PADDING + 32];
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof;
+    int64_t i64;
+    uint64_t u64;
+    double d;
+    char c;
+
+    err = libis_source_create_from_buffer(libis, &source, text, sizeof(text) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+
+    err = libis_read_uint64(libis, input, &eof, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == 123);
+    skip_space(input);
+    err = libis_read_int64(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(i64 == -45);
+    skip_space(input);
+    err = libis_read_int64(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(i64 == 0);
+    skip_space(input);
+    err = libis_read_uint64(libis, input, &eof, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == UINT64_MAX);
+    skip_space(input);
+    err = libis_read_uint64(libis, input, &eof, &u64);
+    assert(!eof && LIBIS_ERROR_OUT_OF_RANGE == err);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == 18446744073709551616.0);
+    skip_space(input);
+    err = libis_read_int64(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(i64 == INT64_MIN);
+    skip_space(input);
+    err = libis_read_int64(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_OUT_OF_RANGE == err);
+    err = libis_read_uint64(libis, input, &eof, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == 9223372036854775808u);
+    skip_space(input);
+    err = libis_read_uint64_hex(libis, input, &eof, &u64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(u64 == 0xFF);
+    skip_space(input);
+    err = libis_read_int64_hex(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(i64 == -0x7F);
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == 3.25);
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == -1e3);
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == .5e-2);
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == 7);
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == 'e');
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == 12345678901234567890.5);
+    skip_space(input);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_MALFORMED == err);
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == '-');
+    skip_space(input);
+    err = libis_read_int64(libis, input, &eof, &i64);
+    assert(!eof && LIBIS_ERROR_MALFORMED == err);
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Number straddles two blocks read from source.
+    memset(straddling, ' ', PADDING);
+    strcpy(straddling + PADDING, "1234567890123.25");
+    err = libis_source_create_from_buffer(libis, &source, straddling, strlen(straddling), false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    for (int i = 0; i < PADDING; ++i) {
+        skip_space(input);
+    }
+    err = libis_read_double(libis, input, &eof, &d);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(d == 1234567890123.25);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+// Numbers use '.' as radix character whatever LC_NUMERIC is.
+static void test_numbers_locale(void) {
+    static const char text[] = "3.14159265358979323846 x";
+    static const char *const locales[] = { "C", "de_DE.UTF-8", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof;
+    double d;
+    char c;
+
+    for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); ++i) {
+        if (!setlocale(LC_NUMERIC, locales[i])) {
+            continue;
+        }
+        err = libis_source_create_from_buffer(libis, &source, text, sizeof(text) - 1, false);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_create(libis, &input, &source, 1);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_read_double(libis, input, &eof, &d);
+        assert(!eof && LIBIS_ERROR_OK == err);
+        assert(d == 3.14159265358979323846);
+        err = libis_read_char(libis, input, &eof, &c);
+        assert(!eof && LIBIS_ERROR_OK == err);
+        assert(c == ' ');
+        err = libis_destroy(libis, &input);
+        assert(LIBIS_ERROR_OK == err);
+    }
+    setlocale(LC_NUMERIC, "C");
+}
+
+static void test_utf8(void) {
+    // "aé€😀" then overlong encoding of '/' and a truncated 3 byte sequence.
+    static const char text[] = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80" "\xC0\xAF" "\xE2\x82";
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof, valid;
+    uint32_t code_point;
+    char span[16];
+    size_t nread;
+
+    err = libis_source_create_from_buffer(libis, &source, text, sizeof(text) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(code_point == 'a');
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(code_point == 0xE9);
+    err = libis_read_utf8_span(libis, input, &eof, span, 4, &nread);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(nread == 3 && !memcmp(span, "\xE2\x82\xAC", 3));
+    err = libis_read_utf8_span(libis, input, &eof, span, 3, &nread);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(nread == 0);
+    err = libis_read_utf8_span(libis, input, &eof, span, sizeof(span), &nread);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(nread == 4);
+    err = libis_read_utf8_span(libis, input, &eof, span, sizeof(span), &nread);
+    assert(!eof && LIBIS_ERROR_MALFORMED == err);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_MALFORMED == err);
+    err = libis_validate_utf8(libis, input, &eof, 2, &valid);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(!valid);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_MALFORMED == err);
+    err = libis_validate_utf8(libis, input, &eof, 2, &valid);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(!valid);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    err = libis_source_create_from_buffer(libis, &source, text, 10, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_validate_utf8(libis, input, &eof, 10, &valid);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(valid);
+    err = libis_validate_utf8(libis, input, &eof, 1, &valid);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+static void test_checksum(void) {
+    static const char digits[] = "123456789";
+    static const LibisChecksumKind kinds[] = { LIBIS_CRC32, LIBIS_CRC32C, LIBIS_XXH64 };
+    static const uint64_t expected[] = { 0xCBF43926, 0xE3069283, 0x8CB841DB40E6AE83 };
+    char bytes[100];
+    uint32_t values[100];
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof;
+    char c;
+    uint64_t checksum;
+
+    for (int i = 0; i < 3; ++i) {
+        err = libis_source_create_from_buffer(libis, &source, digits, sizeof(digits) - 1, false);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_create(libis, &input, &source, 1);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_checksum_begin(libis, input, kinds[i]);
+        assert(LIBIS_ERROR_OK == err);
+        do {
+            err = libis_read_char(libis, input, &eof, &c);
+            assert(LIBIS_ERROR_OK == err);
+        } while (!eof);
+        err = libis_checksum_end(libis, input, &checksum);
+        assert(LIBIS_ERROR_OK == err);
+        assert(checksum == expected[i]);
+        err = libis_checksum_end(libis, input, &checksum);
+        assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+        err = libis_destroy(libis, &input);
+        assert(LIBIS_ERROR_OK == err);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        bytes[i] = (char) i;
+    }
+    err = libis_source_create_from_buffer(libis, &source, bytes, sizeof(bytes), false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_checksum_begin(libis, input, LIBIS_CRC32);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_read_bitpacked_u32(libis, input, &eof, 8, values, 3);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    err = libis_checksum_begin(libis, input, LIBIS_XXH64);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_read_bitpacked_u32(libis, input, &eof, 8, values, 97);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    err = libis_checksum_end(libis, input, &checksum);
+    assert(LIBIS_ERROR_OK == err);
+    assert(checksum == 0x2B44FBCA768FD925);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+#if defined(LIBIS_WITH_ZLIB)
+// Compress size bytes of text into *out with given zlib window bits and return compressed size.
+static size_t deflate_text(const char *text, size_t size, int window_bits, char **out) {
+    z_stream stream = { 0 };
+    int status = deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+    assert(Z_OK == status);
+    size_t capacity = deflateBound(&stream, size);
+    *out = malloc(capacity);
+    assert(*out);
+    stream.next_in = (Bytef *) text;
+    stream.avail_in = size;
+    stream.next_out = (Bytef *) *out;
+    stream.avail_out = capacity;
+    status = deflate(&stream, Z_FINISH);
+    assert(Z_STREAM_END == status);
+    deflateEnd(&stream);
+    return stream.total_out;
+}
+
+static void test_inflate(void) {
+    static const int window_bits[] = { 16 + MAX_WBITS, MAX_WBITS, -MAX_WBITS };
+    static const LibisCompressionFormat formats[] = { LIBIS_FORMAT_GZIP, LIBIS_FORMAT_ZLIB, LIBIS_FORMAT_RAW };
+    enum { SIZE = 300000 };
+    char *text = malloc(SIZE), *compressed, *twice;
+    LibisSource *inner, *source;
+    LibisInputStream *input;
+    bool eof;
+    uint32_t u32;
+    char c;
+    size_t size;
+
+    assert(text);
+    for (uint32_t i = 0; i < SIZE / 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            text[4 * i + j] = (char) (i >> 8 * j);
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        size = deflate_text(text, SIZE, window_bits[i], &compressed);
+        err = libis_source_create_from_buffer(libis, &inner, compressed, size, true);
+        assert(LIBIS_ERROR_OK == err);
+        err = libis_source_create_inflate(libis, &source, &inner, formats[i]);
+        assert(LIBIS_ERROR_OK == err && !inner);
+        err = libis_create(libis, &input, &source, 1);
+        assert(LIBIS_ERROR_OK == err);
+        for (uint32_t j = 0; j < SIZE / 4; ++j) {
+            err = libis_read_u32_le(libis, input, &eof, &u32);
+            assert(!eof && LIBIS_ERROR_OK == err);
+            assert(u32 == j);
+        }
+        err = libis_read_char(libis, input, &eof, &c);
+        assert(eof && LIBIS_ERROR_OK == err);
+        err = libis_destroy(libis, &input);
+        assert(LIBIS_ERROR_OK == err);
+    }
+
+    // Concatenated gzip members read as one stream, truncated stream is malformed.
+    size = deflate_text(text, 1000, 16 + MAX_WBITS, &compressed);
+    twice = malloc(2 * size);
+    assert(twice);
+    memcpy(twice, compressed, size);
+    memcpy(twice + size, compressed, size);
+    err = libis_source_create_from_buffer(libis, &inner, twice, 2 * size - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_source_create_inflate(NULL, &source, &inner, LIBIS_FORMAT_GZIP);
+    assert(LIBIS_ERROR_BAD_ARGUMENT == err);
+    assert(inner);
+    err = libis_source_create_inflate(libis, &source, &inner, LIBIS_FORMAT_GZIP);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    for (int i = 0; i < 2; ++i) {
+        for (uint32_t j = 0; j < 250; ++j) {
+            err = libis_read_u32_le(libis, input, &eof, &u32);
+            assert(!eof && LIBIS_ERROR_OK == err);
+            assert(u32 == j);
+        }
+    }
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(LIBIS_ERROR_MALFORMED == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    free(twice);
+    free(compressed);
+    free(text);
+}
+#endif
+
+static void test_position(void) {
+    static const char text[] = "ab\ncd\n\nefghijklmnop\nq";
+    static const uint64_t lines[] = { 1, 1, 1, 2, 2, 2, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5 };
+    static const uint64_t columns[] = { 1, 2, 3, 1, 2, 3, 1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 1, 2, 2 };
+    enum { LINES = 3000, LINE_LENGTH = 100 };
+    char *long_text = malloc(LINES * LINE_LENGTH);
+    LibisSource *source;
+    LibisInputStream *input;
+    bool eof;
+    char c;
+    uint64_t offset, line, column;
+
+    err = libis_source_create_from_buffer(libis, &source, text, sizeof(text) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_get_position(libis, input, &offset, &line, &column);
+    assert(LIBIS_ERROR_OK == err);
+    assert(offset == 0 && line == 0 && column == 0);
+    err = libis_enable_position_tracking(libis, input);
+    assert(LIBIS_ERROR_OK == err);
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+        err = libis_get_position(libis, input, &offset, &line, &column);
+        assert(LIBIS_ERROR_OK == err);
+        assert(offset == (i < sizeof(text) - 1 ? i : sizeof(text) - 1));
+        assert(line == lines[i] && column == columns[i]);
+        err = libis_read_char(libis, input, &eof, &c);
+        assert(LIBIS_ERROR_OK == err);
+    }
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Lines get counted across buffer refills.
+    assert(long_text);
+    memset(long_text, 'x', LINES * LINE_LENGTH);
+    for (int i = 0; i < LINES; ++i) {
+        long_text[i * LINE_LENGTH + LINE_LENGTH - 1] = '\n';
+    }
+    err = libis_source_create_from_buffer(libis, &source, long_text, LINES * LINE_LENGTH, true);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_enable_position_tracking(libis, input);
+    assert(LIBIS_ERROR_OK == err);
+    for (int i = 0; i < (LINES - 1) * LINE_LENGTH + 10; ++i) {
+        err = libis_read_char(libis, input, &eof, &c);
+        assert(!eof && LIBIS_ERROR_OK == err);
+    }
+    err = libis_get_position(libis, input, &offset, &line, &column);
+    assert(LIBIS_ERROR_OK == err);
+    assert(offset == (LINES - 1) * LINE_LENGTH + 10 && line == LINES && column == 11);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+#if defined(__linux__)
+enum { THREADS = 4, THREAD_WORDS = 1 << 16, THREAD_READS = 10000 };
+
+// Check random positional reads from source shared by all threads.
+static void *read_at_thread(void *arg) {
+    LibisSource *source = arg;
+    uint32_t state = (uint32_t) (uintptr_t) pthread_self(), word, value;
+    bool eof;
+    LibisError thread_err;
+    for (int i = 0; i < THREAD_READS; ++i) {
+        state = state * 1664525 + 1013904223;
+        word = state % THREAD_WORDS;
+        thread_err = libis_read_u32_le_at(libis, source, &eof, 4 * (uint64_t) word, &value);
+        assert(!eof && LIBIS_ERROR_OK == thread_err);
+        assert(value == word);
+    }
+    return NULL;
+}
+
+static void test_read_at_threads(void) {
+    static uint32_t words[THREAD_WORDS];
+    uint32_t span[THREAD_WORDS / 4];
+    static const unsigned flags[] = { 0, LIBIS_FD_DIRECT };
+    pthread_t threads[THREADS];
+    LibisSource *source;
+    FILE *file;
+    bool eof;
+    int fd;
+
+    for (uint32_t i = 0; i < THREAD_WORDS; ++i) {
+        unsigned char *p = (unsigned char *) &words[i];
+        p[0] = (unsigned char) i;
+        p[1] = (unsigned char) (i >> 8);
+        p[2] = (unsigned char) (i >> 16);
+        p[3] = (unsigned char) (i >> 24);
+    }
+    file = fopen("test_threads.bin", "wb");
+    assert(file);
+    assert(1 == fwrite(words, sizeof(words), 1, file));
+    assert(!fclose(file));
+
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i) {
+        fd = open("test_threads.bin", O_RDONLY);
+        assert(0 <= fd);
+        err = libis_source_create_from_file_descriptor_with_flags(libis, &source, &fd, flags[i]);
+        assert(LIBIS_ERROR_OK == err);
+        for (int j = 0; j < THREADS; ++j) {
+            assert(!pthread_create(&threads[j], NULL, read_at_thread, source));
+        }
+        for (int j = 0; j < THREADS; ++j) {
+            assert(!pthread_join(threads[j], NULL));
+        }
+        // Reads larger than the stack bounce block
+        err = libis_read_at(libis, source, &eof, 6, (char *) span, sizeof(span));
+        assert(!eof && LIBIS_ERROR_OK == err);
+        assert(!memcmp(span, (const char *) words + 6, sizeof(span)));
+        err = libis_source_destroy(libis, &source);
+        assert(LIBIS_ERROR_OK == err);
+    }
+
+    err = libis_source_create_from_buffer(libis, &source, (const char *) words, sizeof(words), false);
+    assert(LIBIS_ERROR_OK == err);
+    for (int j = 0; j < THREADS; ++j) {
+        assert(!pthread_create(&threads[j], NULL, read_at_thread, source));
+    }
+    for (int j = 0; j < THREADS; ++j) {
+        assert(!pthread_join(threads[j], NULL));
+    }
+    err = libis_source_destroy(libis, &source);
+    assert(LIBIS_ERROR_OK == err);
+    remove("test_threads.bin");
+}
+
+// Count pages of file which are in page cache.
+static size_t resident_pages(int fd, size_t size) {
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE), pages = (size + page_size - 1) / page_size, resident = 0;
+    unsigned char *residency = malloc(pages);
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    assert(residency && mapping != MAP_FAILED);
+    assert(!mincore(mapping, size, residency));
+    for (size_t i = 0; i < pages; ++i) {
+        resident += residency[i] & 1;
+    }
+    assert(!munmap(mapping, size));
+    free(residency);
+    return resident;
+}
+
+// Scanning with LIBIS_FD_DROP_BEHIND leaves the file out of page cache.
+static void test_drop_behind(void) {
+    enum { SIZE = 32 * 1024 * 1024 + 12345 };
+    static char block[65536];
+    LibisSource *source;
+    LibisInputStream *input;
+    size_t pages, written = 0, available;
+    const char *window;
+    bool eof;
+    char c;
+    int fd;
+
+    fd = open("test_drop_behind.bin", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(0 <= fd);
+    memset(block, 'x', sizeof(block));
+    while (written < SIZE) {
+        size_t n = SIZE - written < sizeof(block) ? SIZE - written : sizeof(block);
+        assert((ssize_t) n == write(fd, block, n));
+        written += n;
+    }
+    assert(!fsync(fd));
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    pages = resident_pages(fd, SIZE);
+    assert(!close(fd));
+    if (pages) {
+        // File system keeps files in memory like tmpfs does.
+        remove("test_drop_behind.bin");
+        return;
+    }
+
+    fd = open("test_drop_behind.bin", O_RDONLY);
+    assert(0 <= fd);
+    err = libis_source_create_from_file_descriptor_with_flags(libis, &source, &fd, LIBIS_FD_DROP_BEHIND);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+    for (written = 0; written < SIZE; written += available) {
+        err = libis_peek(libis, input, &eof, sizeof(block), &window, &available);
+        assert(LIBIS_ERROR_OK == err && available);
+        err = libis_consume(libis, input, available);
+        assert(LIBIS_ERROR_OK == err);
+    }
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(eof && LIBIS_ERROR_OK == err);
+
+    fd = open("test_drop_behind.bin", O_RDONLY);
+    assert(0 <= fd);
+    pages = resident_pages(fd, SIZE);
+    assert(pages < SIZE / 4096 / 64);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+    assert(!close(fd));
+    remove("test_drop_behind.bin");
+}
+
+// Sources must return bytes which are available rather than wait for a whole block.
+static void test_pipes(void) {
+    LibisSource *source;
+    LibisInputStream *input;
+    int fds[2];
+    FILE *file;
+    unsigned flags;
+    bool eof;
+    char c;
+
+    assert(!pipe(fds));
+    assert(1 == write(fds[1], "A", 1));
+    file = fdopen(fds[0], "rb");
+    assert(file);
+    err = libis_source_create_from_file(libis, &source, &file);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Fail instead of hanging if reading waits for more bytes.
+    alarm(5);
+    err = libis_read_char(libis, input, &eof, &c);
+    alarm(0);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == 'A');
+
+    close(fds[1]);
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    // Pipes have neither page cache nor O_DIRECT so flags are dropped.
+    assert(!pipe(fds));
+    assert(1 == write(fds[1], "B", 1));
+    err = libis_source_create_from_file_descriptor_with_flags(
+            libis, &source, &fds[0], LIBIS_FD_SEQUENTIAL | LIBIS_FD_DROP_BEHIND | LIBIS_FD_DIRECT);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_source_get_file_descriptor_flags(libis, source, &flags);
+    assert(LIBIS_ERROR_OK == err);
+    assert(flags == 0);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+
+    alarm(5);
+    err = libis_read_char(libis, input, &eof, &c);
+    alarm(0);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == 'B');
+
+    close(fds[1]);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+// UTF-8 readers wait only for bytes of the next code point.
+static void test_pipes_utf8(void) {
+    LibisSource *source;
+    LibisInputStream *input;
+    int fds[2];
+    FILE *file;
+    uint32_t code_point;
+    char span[16];
+    size_t nread;
+    bool eof, valid;
+
+    assert(!pipe(fds));
+    assert(2 == write(fds[1], "a\n", 2));
+    file = fdopen(fds[0], "rb");
+    assert(file);
+    err = libis_source_create_from_file(libis, &source, &file);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+
+    alarm(5);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(code_point == 'a');
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(code_point == '\n');
+
+    assert(3 == write(fds[1], "\xC3\xA9\n", 3));
+    // Span stops at the end of bytes read so far which may be short of all written ones.
+    for (size_t total = 0; total < 3; total += nread) {
+        err = libis_read_utf8_span(libis, input, &eof, span + total, sizeof(span) - total, &nread);
+        assert(!eof && LIBIS_ERROR_OK == err);
+        assert(nread);
+    }
+    assert(!memcmp(span, "\xC3\xA9\n", 3));
+
+    assert(2 == write(fds[1], "xy", 2));
+    err = libis_validate_utf8(libis, input, &eof, 2, &valid);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(valid);
+    alarm(0);
+
+    close(fds[1]);
+    err = libis_read_codepoint(libis, input, &eof, &code_point);
+    assert(eof && LIBIS_ERROR_OK == err);
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+}
+
+// Reading with O_DIRECT from an unaligned offset falls back to page cache.
+static void test_direct_fallback(void) {
+    LibisSource *source, *file_descriptor_source;
+    LibisInputStream *input;
+    unsigned flags;
+    bool eof;
+    char c;
+    int fd;
+
+    fd = open("test.bin", O_RDONLY);
+    assert(0 <= fd);
+    assert(1 == lseek(fd, 1, SEEK_SET));
+    err = libis_source_create_from_file_descriptor_with_flags(libis, &source, &fd, LIBIS_FD_DIRECT);
+    assert(LIBIS_ERROR_OK == err);
+    file_descriptor_source = source;
+    err = libis_create(libis, &input, &source, 1);
+    assert(LIBIS_ERROR_OK == err);
+
+    for (size_t i = 1; i < sizeof(buffer) - 1; ++i) {
+        err = libis_read_char(libis, input, &eof, &c);
+        assert(!eof && LIBIS_ERROR_OK == err);
+        assert(c == buffer[i]);
+    }
+    err = libis_read_char(libis, input, &eof, &c);
+    assert(eof && LIBIS_ERROR_OK == err);
+
+    err = libis_source_get_file_descriptor_flags(libis, file_descriptor_source, &flags);
+    assert(LIBIS_ERROR_OK == err);
+    assert(!(flags & LIBIS_FD_DIRECT));
+
+    err = libis_destroy(libis, &input);
+    assert(LIBIS_ERROR_OK == err);
+
+    err = libis_source_create_from_buffer(libis, &source, buffer, sizeof(buffer) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    err = libis_source_get_file_descriptor_flags(libis, source, &flags);
+    assert(LIBIS_ERROR_NOT_SUPPORTED == err);
+    err = libis_source_destroy(libis, &source);
+    assert(LIBIS_ERROR_OK == err);
+}
+#endif
+
 int main() {
     err = libis_start(&libis);
     assert(LIBIS_ERROR_OK == err);
@@ -105,6 +1043,28 @@ int main() {
     assert(LIBIS_ERROR_OK == err);
     test(&source);
 
+    err = libis_source_create_from_buffer(libis, &source, buffer, sizeof(buffer) - 1, false);
+    assert(LIBIS_ERROR_OK == err);
+    test_read_at(source);
+
+    test_bitpacked();
+
+    test_schema();
+
+    test_numbers();
+
+    test_numbers_locale();
+
+    test_utf8();
+
+    test_checksum();
+
+    test_position();
+
+#if defined(LIBIS_WITH_ZLIB)
+    test_inflate();
+#endif
+
     FILE *file = fopen("test.bin", "w+b");
     assert(file);
     size_t items = fwrite(buffer, sizeof(buffer) - 1, 1, file);
@@ -120,6 +1080,35 @@ int main() {
     err = libis_source_create_from_file_descriptor(libis, &source, &fd);
     assert(LIBIS_ERROR_OK == err);
     test(&source);
+
+    fd = open("test.bin", O_RDONLY);
+    assert(0 <= fd);
+    err = libis_source_create_from_file_descriptor_with_flags(
+            libis, &source, &fd, LIBIS_FD_SEQUENTIAL | LIBIS_FD_DROP_BEHIND | LIBIS_FD_DIRECT);
+    assert(LIBIS_ERROR_OK == err);
+    test(&source);
+
+    fd = open("test.bin", O_RDONLY);
+    assert(0 <= fd);
+    err = libis_source_create_from_file_descriptor(libis, &source, &fd);
+    assert(LIBIS_ERROR_OK == err);
+    test_read_at(source);
+
+    fd = open("test.bin", O_RDONLY);
+    assert(0 <= fd);
+    err = libis_source_create_from_file_descriptor_with_flags(libis, &source, &fd, LIBIS_FD_DIRECT);
+    assert(LIBIS_ERROR_OK == err);
+    test_read_at(source);
+
+    test_read_at_threads();
+
+    test_drop_behind();
+
+    test_pipes();
+
+    test_pipes_utf8();
+
+    test_direct_fallback();
 #endif
 
     err = libis_finish(&libis);
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <libis.hpp>
+#include <vector>
+
+static const char buffer[] =
+        "\x10"
+        "\x20\x21"
+        "\x31\x30"
+        "\x40\x41\x42\x43"
+        "\x53\x52\x51\x50"
+        "\x60\x61\x62\x63\x64\x65\x66\x67"
+        "\x77\x76\x75\x74\x73\x72\x71\x70"
+        "X";
+
+static std::span<const std::byte> bytes(const char *text, std::size_t size) {
+    return { reinterpret_cast<const std::byte *>(text), size };
+}
+
+static void test_typed_reads(libis::Context &context) {
+    libis::Stream stream(context, libis::Source::from_buffer(context, bytes(buffer, sizeof(buffer) - 1)));
+
+    assert(stream.read<std::uint8_t>() == 0x10);
+    assert((stream.read<std::uint16_t, std::endian::little>() == 0x2120));
+    assert((stream.read<std::uint16_t, std::endian::big>() == 0x3130));
+    assert(stream.read<std::uint32_t>() == 0x43424140);
+    assert((stream.read<std::uint32_t, std::endian::big>() == 0x53525150));
+    assert(stream.read<std::uint64_t>() == 0x6766656463626160);
+    assert((stream.read<std::int64_t, std::endian::big>() == 0x7776757473727170));
+
+    // Bytes read through the wrapper get consumed before calling C functions directly.
+    bool eof;
+    char c;
+    LibisError err = libis_read_char(context.get(), stream.get(), &eof, &c);
+    assert(!eof && LIBIS_ERROR_OK == err);
+    assert(c == 'X');
+
+    std::uint32_t u32 = 0;
+    assert(!stream.try_read(u32));
+    assert(stream.at_end());
+    bool thrown = false;
+    try {
+        stream.read<std::uint8_t>();
+    } catch (const libis::EndOfStream &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+static void test_floats(libis::Context &context) {
+    unsigned char data[12];
+    float f = 1.5f;
+    double d = -0.25;
+    std::uint32_t f_bits = std::bit_cast<std::uint32_t>(f);
+    std::uint64_t d_bits = std::bit_cast<std::uint64_t>(d);
+    for (int i = 0; i < 4; ++i) {
+        data[i] = static_cast<unsigned char>(f_bits >> 8 * (3 - i));
+    }
+    for (int i = 0; i < 8; ++i) {
+        data[4 + i] = static_cast<unsigned char>(d_bits >> 8 * i);
+    }
+
+    libis::Stream stream(context, libis::Source::from_buffer(context, std::as_bytes(std::span(data))));
+    assert((stream.read<float, std::endian::big>() == 1.5f));
+    assert(stream.read<double>() == -0.25);
+    assert(stream.at_end());
+}
+
+static void test_spans(libis::Context &context) {
+    static const char text[] = "header:payload";
+    libis::Stream stream(context, libis::Source::from_buffer(context, bytes(text, sizeof(text) - 1)));
+
+    std::span<const std::byte> view = stream.peek(6);
+    assert(view.size() == 6 && !std::memcmp(view.data(), "header", 6));
+    view = stream.read_span(7);
+    assert(view.size() == 7 && !std::memcmp(view.data(), "header:", 7));
+    view = stream.peek(100);
+    assert(view.size() == 7 && !std::memcmp(view.data(), "payload", 7));
+
+    stream.skip(3);
+    bool thrown = false;
+    try {
+        stream.read_span(5);
+    } catch (const libis::EndOfStream &) {
+        thrown = true;
+    }
+    assert(thrown);
+    view = stream.read_span(4);
+    assert(!std::memcmp(view.data(), "load", 4));
+    assert(stream.at_end());
+}
+
+static void test_iterators(libis::Context &context) {
+    // Longer than a block of the stream buffer so iteration has to refill it.
+    std::vector<char> data(200000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i % 251);
+    }
+
+    libis::Stream stream(context, libis::Source::from_buffer(context, bytes(data.data(), data.size())));
+    assert(std::count(stream.begin(), stream.end(), std::byte{ 250 }) == 200000 / 251);
+    assert(stream.at_end());
+
+    libis::Stream stream2(context, libis::Source::from_buffer(context, bytes(data.data(), data.size())));
+    auto it = std::find(stream2.begin(), stream2.end(), std::byte{ 100 });
+    assert(it != stream2.end() && *it == std::byte{ 100 });
+    assert(*it++ == std::byte{ 100 });
+    assert(*it == std::byte{ 101 });
+    assert(stream2.read<std::uint8_t>() == 101);
+
+    std::vector<std::byte> copied;
+    for (std::byte b : stream2) {
+        copied.push_back(b);
+    }
+    assert(copied.size() == data.size() - 102);
+    assert(copied.back() == std::byte(static_cast<unsigned char>(data.back())));
+}
+
+static void test_positional_reads(libis::Context &context) {
+    libis::Source source = libis::Source::from_buffer(context, bytes(buffer, sizeof(buffer) - 1));
+    assert((source.read_at<std::uint16_t, std::endian::big>(3) == 0x3130));
+    assert(source.read_at<std::uint64_t>(13) == 0x6766656463626160);
+    bool thrown = false;
+    try {
+        source.read_at<std::uint32_t>(sizeof(buffer) - 2);
+    } catch (const libis::EndOfStream &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // Stream takes ownership of the source.
+    libis::Stream stream(context, std::move(source));
+    assert(!source.get());
+    assert(stream.read<std::uint8_t>() == 0x10);
+}
+
+static void test_errors(libis::Context &context) {
+    static const char text[] = "12x";
+    libis::Stream stream(context, libis::Source::from_buffer(context, bytes(text, sizeof(text) - 1)));
+    stream.skip(2);
+    bool eof;
+    std::int64_t value;
+    try {
+        libis::check(libis_read_int64(context.get(), stream.get(), &eof, &value));
+        assert(false);
+    } catch (const libis::Error &e) {
+        assert(e.code() == LIBIS_ERROR_MALFORMED);
+    }
+    assert(stream.read<char>() == 'x');
+}
+
+int main() {
+    libis::Context context;
+
+    test_typed_reads(context);
+
+    test_floats(context);
+
+    test_spans(context);
+
+    test_iterators(context);
+
+    test_positional_reads(context);
+
+    test_errors(context);
+
+    libis::Context moved = std::move(context);
+    assert(!context.get() && moved.get());
+
+    return 0;
+}